@@ -0,0 +1,396 @@
+#include "hive.hpp"
+#include "column_hive.hpp"
+#include "concurrent_hive.hpp"
+#include "huge_page_allocator.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Counts live bytes so each layout's footprint can be reported next to its speed
+inline size_t g_bytes_allocated{ };
+
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept { }
+
+    T* allocate(size_t n)
+    {
+        g_bytes_allocated += n * sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        g_bytes_allocated -= n * sizeof(T);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const noexcept { return true; }
+};
+
+template <typename Func>
+double time_ms(Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Fills a hive, erases a fraction of it at random and times full iterations
+template <typename Skipfield>
+void bench_layout(const char* name, size_t count, double erase_ratio)
+{
+    constexpr int ITERATIONS{ 20 };
+    hive<int, CountingAllocator<int>, Skipfield> h;
+    for (size_t i{}; i<count; ++i)
+        h.emplace(static_cast<int>(i));
+
+    std::mt19937 rng{ 42 };
+    std::bernoulli_distribution should_erase{ erase_ratio };
+    for (auto it = h.begin(); it != h.end(); )
+        it = should_erase(rng) ? h.erase(it) : ++it;
+
+    volatile long long sink{ };
+    const double ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+        {
+            long long sum{ };
+            for (const int val : h)
+                sum += val;
+            sink = sink + sum;
+        }
+    });
+
+    std::printf("%-10s erased %3.0f%%  %6.2f bytes/slot  %7.3f ns/element\n",
+                name, erase_ratio * 100.0,
+                static_cast<double>(g_bytes_allocated) / static_cast<double>(h.capacity()),
+                ms * 1e6 / (static_cast<double>(h.size()) * ITERATIONS));
+}
+
+// Counts active slots of a block sized skipfield with the old one slot at a time loop and
+// with the vectorized kernel, erased runs are laid out as hive writes them
+void bench_skipfield_scan(double erase_ratio)
+{
+    constexpr size_t SLOTS{ 8192 };
+    constexpr int ITERATIONS{ 20000 };
+
+    std::mt19937 rng{ 42 };
+    std::bernoulli_distribution should_erase{ erase_ratio };
+    std::vector<std::uint16_t> skip(SLOTS, 0);
+    for (size_t idx{}; idx<SLOTS; )
+    {
+        size_t run{ };
+        while (idx + run < SLOTS && should_erase(rng))
+            ++run;
+        if (run != 0)
+            skip[idx] = skip[idx + run - 1] = static_cast<std::uint16_t>(run);
+        idx += run + 1;
+    }
+
+    volatile size_t sink{ };
+    const double scalar_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+        {
+            size_t count{ };
+            for (size_t idx{}; idx<SLOTS; )
+            {
+                if (skip[idx] == 0) { ++count; ++idx; }
+                else idx += skip[idx];
+            }
+            sink = sink + count;
+        }
+    });
+    const double simd_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+            sink = sink + hive_detail::count_active(skip.data(), 0, SLOTS);
+    });
+
+    std::printf("erased %3.0f%%  scalar %7.3f  simd %7.3f ns/slot  %5.2fx\n",
+                erase_ratio * 100.0,
+                scalar_ms * 1e6 / (SLOTS * ITERATIONS), simd_ms * 1e6 / (SLOTS * ITERATIONS),
+                scalar_ms / simd_ms);
+}
+
+// dTLB load misses of the calling thread while func runs, -1 when perf events are unavailable
+template <typename Func>
+long long dtlb_misses(Func&& func)
+{
+#if defined(__linux__)
+    perf_event_attr attr{ };
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        func();
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        long long misses{ -1 };
+        if (read(fd, &misses, sizeof(misses)) != sizeof(misses))
+            misses = -1;
+        close(fd);
+        return misses;
+    }
+#endif
+    func();
+    return -1;
+}
+
+// Iterates a large hive with uint32 skipfields, whose last blocks grow past a huge page,
+// with every fourth element erased, and reports time and dTLB misses per element
+template <typename Allocator>
+void bench_tlb(const char* name, size_t count)
+{
+    hive<int, Allocator, std::uint32_t> h;
+    h.insert(count, 1);
+    std::iota(h.begin(), h.end(), 0);
+    erase_if(h, [](int val) { return val % 4 == 0; });
+
+    volatile long long sink{ };
+    double ms{ };
+    const long long misses = dtlb_misses([&]
+    {
+        ms = time_ms([&]
+        {
+            for (int rep{}; rep<5; ++rep)
+                sink = sink + h.parallel_reduce(0LL, std::plus<>{}, 1);
+        });
+    });
+
+    const double elements{ static_cast<double>(h.size()) * 5.0 };
+    if (misses >= 0)
+        std::printf("%-12s %7.3f ns/element  %8.5f dTLB misses/element\n", name, ms * 1e6 / elements,
+                    static_cast<double>(misses) / elements);
+    else
+        std::printf("%-12s %7.3f ns/element  dTLB counter unavailable\n", name, ms * 1e6 / elements);
+}
+
+// Sums a hive<float> through its iterators and through its segments, whose inner loops
+// have no skipfield checks and can be vectorized
+void bench_segments(size_t count, double erase_ratio)
+{
+    constexpr int ITERATIONS{ 20 };
+    hive<float> h;
+    h.insert(count, 1.0f);
+
+    std::mt19937 rng{ 42 };
+    std::bernoulli_distribution should_erase{ erase_ratio };
+    erase_if(h, [&](float) { return should_erase(rng); });
+
+    volatile float sink{ };
+    const double iterator_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+        {
+            float sum{ };
+            for (const float val : h)
+                sum += val;
+            sink = sink + sum;
+        }
+    });
+    const double segment_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+        {
+            float sum{ };
+            h.for_each_segment([&sum](std::span<const float> seg)
+            {
+                for (const float val : seg)
+                    sum += val;
+            });
+            sink = sink + sum;
+        }
+    });
+
+    const double elements{ static_cast<double>(h.size()) * ITERATIONS };
+    std::printf("erased %3.0f%%  iterator %7.3f  segments %7.3f ns/element\n",
+                erase_ratio * 100.0, iterator_ms * 1e6 / elements, segment_ms * 1e6 / elements);
+}
+
+// Position update touching two of five fields, rows in a hive vs columns in a column_hive
+void bench_columns(size_t count)
+{
+    constexpr int ITERATIONS{ 20 };
+    struct Particle
+    {
+        float position;
+        float velocity;
+        float mass;
+        float color[4];
+        std::uint64_t id;
+    };
+
+    hive<Particle> rows;
+    column_hive<float, float, float, std::array<float, 4>, std::uint64_t> columns;
+    for (size_t i{}; i<count; ++i)
+    {
+        rows.emplace(Particle{ 0.0f, 1.0f, 1.0f, { }, i });
+        columns.emplace(0.0f, 1.0f, 1.0f, std::array<float, 4>{ }, i);
+    }
+
+    const double rows_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+            rows.for_each_segment([](std::span<Particle> seg)
+            {
+                for (Particle& p : seg)
+                    p.position += p.velocity;
+            });
+    });
+    const double columns_ms = time_ms([&]
+    {
+        for (int rep{}; rep<ITERATIONS; ++rep)
+            columns.for_each_segment<0, 1>([](std::span<float> pos, std::span<float> vel)
+            {
+                for (size_t i{}; i<pos.size(); ++i)
+                    pos[i] += vel[i];
+            });
+    });
+
+    const double elements{ static_cast<double>(count) * ITERATIONS };
+    std::printf("hive<Particle> %7.3f  column_hive %7.3f ns/element\n",
+                rows_ms * 1e6 / elements, columns_ms * 1e6 / elements);
+}
+
+// hive::sort in place vs copying out to a Vector, sorting and re-emplacing
+template <typename T, typename Make>
+void bench_sort(const char* name, size_t count, Make make)
+{
+    std::mt19937 rng{ 42 };
+    hive<T> source;
+    for (size_t i{}; i<count; ++i)
+        source.emplace(make(rng));
+    std::bernoulli_distribution should_erase{ 0.25 };
+    erase_if(source, [&](const T&) { return should_erase(rng); });
+
+    hive<T> in_place{ source };
+    const double in_place_ms = time_ms([&] { in_place.sort(); });
+
+    hive<T> copied{ source };
+    const double copy_out_ms = time_ms([&]
+    {
+        Vector<T> out;
+        out.reserve(copied.size());
+        for (T& val : copied)
+            out.push_back(std::move(val));
+        std::sort(out.begin(), out.end());
+        copied.clear();
+        for (T& val : out)
+            copied.emplace(std::move(val));
+    });
+
+    std::printf("%-8s sort %8.2f ms  copy out %8.2f ms\n", name, in_place_ms, copy_out_ms);
+}
+
+// Times a per-element update through parallel_for_each with increasing thread counts
+void bench_parallel(size_t count)
+{
+    hive<float> h;
+    h.insert(count, 1.0f);
+
+    for (const size_t threads : { 1, 2, 4, 8 })
+    {
+        const double ms = time_ms([&]
+        {
+            for (int rep{}; rep<10; ++rep)
+                h.parallel_for_each([](float& val) { val = val * 1.0001f + 0.5f; }, threads);
+        });
+        std::printf("parallel_for_each %zu threads  %8.3f ms/pass\n", threads, ms / 10.0);
+    }
+}
+
+// Emplace throughput of concurrent_hive with one shard per producer thread
+void bench_concurrent_emplace(size_t count)
+{
+    for (const size_t threads : { 1, 2, 4, 8 })
+    {
+        concurrent_hive<int> h{ threads };
+        const double ms = time_ms([&]
+        {
+            std::vector<std::jthread> producers;
+            for (size_t t{}; t<threads; ++t)
+            {
+                producers.emplace_back([&h, count, threads]
+                {
+                    for (size_t i{}; i<count / threads; ++i)
+                        h.emplace(static_cast<int>(i));
+                });
+            }
+        });
+        std::printf("concurrent emplace %zu threads  %7.2f M/s\n", threads,
+                    static_cast<double>(h.size()) / (ms * 1e3));
+    }
+}
+
+int main()
+{
+    constexpr size_t COUNT{ 4'000'000 };
+
+    std::printf("--- hive<int> layout: footprint and iteration ---\n");
+    for (const double ratio : { 0.0, 0.25, 0.5, 0.9 })
+    {
+        bench_layout<std::uint8_t >("uint8",  COUNT, ratio);
+        bench_layout<std::uint16_t>("uint16", COUNT, ratio);
+        bench_layout<std::uint32_t>("uint32", COUNT, ratio);
+    }
+
+    std::printf("--- uint16 skipfield active count, %zu byte vectors ---\n", hive_detail::SIMD_BYTES);
+    for (const double ratio : { 0.0, 0.01, 0.1, 0.25, 0.5, 0.9 })
+        bench_skipfield_scan(ratio);
+
+    std::printf("--- hive<float> sum, iterators vs segments ---\n");
+    for (const double ratio : { 0.0, 0.1, 0.5 })
+        bench_segments(COUNT, ratio);
+
+    std::printf("--- position update, rows vs columns ---\n");
+    bench_columns(COUNT);
+
+    std::printf("--- sort, in place vs copy out ---\n");
+    bench_sort<int>("int", COUNT, [](std::mt19937& rng) { return static_cast<int>(rng()); });
+    bench_sort<std::string>("string", COUNT / 4, [](std::mt19937& rng) { return std::to_string(rng()); });
+
+    std::printf("--- hive<int, A, uint32> iteration, block storage ---\n");
+    bench_tlb<std::allocator<int>>("std", COUNT * 8);
+    bench_tlb<huge_page_allocator<int>>("huge pages", COUNT * 8);
+
+    std::printf("--- hive<float> parallel update ---\n");
+    bench_parallel(COUNT * 4);
+
+    std::printf("--- concurrent_hive<int> emplace ---\n");
+    bench_concurrent_emplace(COUNT);
+}
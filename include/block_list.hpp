@@ -0,0 +1,372 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Skip counts live in their own array next to the elements, so the narrower
+// the type the denser the block. A block never holds more slots than the
+// skipfield type can count, which ties the type to the maximum block capacity.
+template <typename S>
+concept hive_skipfield = std::same_as<S, std::uint8_t>  ||
+                         std::same_as<S, std::uint16_t> ||
+                         std::same_as<S, std::uint32_t>;
+
+// Block bookkeeping and allocator propagation shared by hive and column_hive. Both keep their slots in a chain of
+// blocks, each with a skipfield where active slots hold 0 and the first and last slot of
+// an erased run hold its length, and a free list holding one entry per erased run.
+//
+// A Block provides the chain links prev and next (owning), serial_ (its position in the
+// chain), skipfield_, highest_untouched_, free_list_head_, free_runs_, the links
+// prev_with_free_ and next_with_free_, and links(idx) / set_links(idx, links) for the
+// free list entry kept at slot idx.
+namespace hive_detail
+{
+
+// Links of a block's free list, kept at the first slot of each erased run
+template<hive_skipfield S>
+struct free_links
+{
+    S prev;
+    S next;
+};
+
+// Destroys a block header and frees the block's single allocation of Units(capacity)
+// BlockUnits. Stateless allocators take no space, so a block pointer is one pointer.
+template<typename Block, typename BlockAllocator, size_t (*Units)(size_t) noexcept>
+struct block_deleter
+{
+    using AllocTraits = std::allocator_traits<BlockAllocator>;
+
+    [[no_unique_address]] BlockAllocator block_alloc_;
+
+    explicit block_deleter(const BlockAllocator& balloc_ = BlockAllocator()) noexcept
+        : block_alloc_(balloc_)
+    { }
+
+    // allocators need not be assignable (std::pmr::polymorphic_allocator is not),
+    // but copying one never throws. Those are rebuilt as a whole deleter, never as
+    // the block_alloc_ member alone since it may overlap other storage.
+    block_deleter(const block_deleter&) noexcept = default;
+    block_deleter& operator=(const block_deleter& other) noexcept
+    {
+        if constexpr (std::is_copy_assignable_v<BlockAllocator>)
+            block_alloc_ = other.block_alloc_;
+        else if (this != &other)
+        {
+            std::destroy_at(this);
+            std::construct_at(this, other);
+        }
+        return *this;
+    }
+
+    void operator()(Block* block)
+    {
+        if (block == nullptr) return;
+
+        const size_t units{ Units(block->capacity_) };
+        std::destroy_at(block);
+        AllocTraits::deallocate(block_alloc_, reinterpret_cast<typename AllocTraits::value_type*>(block), units);
+    }
+};
+
+/* --- Allocator Propagation --- */
+
+// Move assignment can take the other container's blocks without comparing allocators
+template<typename Allocator>
+inline constexpr bool always_steals_blocks{ std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+                                            std::allocator_traits<Allocator>::is_always_equal::value };
+
+// Copy assignment through a copy built with the allocator self should end up with, so a
+// copy that throws leaves self untouched. Container needs a (const Container&, const
+// Allocator&) constructor and a swap() that exchanges allocators as swap_allocators does.
+template<typename Container, typename Allocator>
+void copy_assign(Container& self, Allocator& self_alloc, const Container& other, const Allocator& other_alloc)
+{
+    constexpr bool propagate{ std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value };
+    Container temp{ other, propagate ? other_alloc : self_alloc };
+    if constexpr (propagate)
+        self_alloc = other_alloc;
+    self.swap(temp);
+}
+
+// Move assignment into an emptied container. Blocks can only be stolen when self's
+// allocator can free them, then steal_blocks() runs, otherwise move_elements() moves the
+// elements one by one into blocks from self's allocator. can_steal is false when the
+// other container's blocks cannot move at all.
+template<typename Allocator, typename StealBlocks, typename MoveElements>
+void move_assign(Allocator& self_alloc, const Allocator& other_alloc, bool can_steal,
+                 StealBlocks&& steal_blocks, MoveElements&& move_elements)
+{
+    if constexpr (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value)
+        self_alloc = other_alloc;
+
+    if ((always_steals_blocks<Allocator> || self_alloc == other_alloc) && can_steal)
+        steal_blocks();
+    else
+        move_elements();
+}
+
+// Allocators are only swapped if they propagate on swap, swapping containers with
+// unequal non propagating allocators is undefined as for the standard containers
+template<typename Allocator>
+void swap_allocators(Allocator& a, Allocator& b) noexcept
+{
+    if constexpr (std::allocator_traits<Allocator>::propagate_on_container_swap::value)
+    {
+        using std::swap;
+        swap(a, b);
+    }
+}
+
+// Appends block to the chain [first, last] and numbers it after the current last block
+template<typename BlockPtr, typename Block>
+void append_block(BlockPtr& first, Block*& last, BlockPtr block) noexcept
+{
+    if (last == nullptr) [[unlikely]]
+    {
+        block->serial_ = 0;
+        first = std::move(block);
+        last = first.get();
+    }
+    else
+    {
+        block->prev = last;
+        block->serial_ = last->serial_ + 1;
+        last->next = std::move(block);
+        last = last->next.get();
+    }
+}
+
+// Per block free lists of erased runs, and the list of blocks that have any. That list
+// is ordered by serial_, so emplace finds a slot without searching and keeps filling
+// the lowest block first.
+template<typename Block, hive_skipfield S>
+class free_block_list
+{
+public:
+    using links_type = free_links<S>;
+
+    // end marker for the index based free lists, never a valid slot index
+    static constexpr S NO_FREE{ std::numeric_limits<S>::max() };
+
+    // lowest block with an erased slot, null if there is none
+    [[nodiscard]] Block* first() const noexcept { return first_; }
+    [[nodiscard]] Block* last() const noexcept { return last_; }
+
+    // idx was the head of an erased run and now holds an element, links are the run's
+    // free list entry, read before the element was constructed over it
+    void on_emplace(Block* block, size_t idx, links_type links) noexcept;
+
+    // count slots from idx were erased, they join any erased run next to them
+    void on_erase(Block* block, size_t idx, size_t count = 1) noexcept;
+
+    void push_free_run(Block* block, size_t idx) noexcept;
+    void unlink_free_run(Block* block, links_type links) noexcept;
+    void relink_free_run(Block* block, size_t new_idx, links_type links) noexcept;
+
+    void link_block(Block* block) noexcept;
+    void unlink_block(Block* block) noexcept;
+
+    // Takes over other's blocks, which must all come after ours
+    void splice(free_block_list& other) noexcept;
+
+    void reset() noexcept
+    {
+        first_ = nullptr;
+        last_ = nullptr;
+    }
+
+    void swap(free_block_list& other) noexcept
+    {
+        std::swap(first_, other.first_);
+        std::swap(last_, other.last_);
+    }
+
+private:
+    Block* first_{ nullptr };
+    Block* last_{ nullptr };
+};
+
+// Unlinks an emptied block from the chain [first, last] and from the free lists, clears
+// its slot bookkeeping and hands back ownership, e.g. to keep it as a spare
+template<typename BlockPtr, typename Block, hive_skipfield S>
+[[nodiscard]] BlockPtr detach_block(BlockPtr& first, Block*& last, free_block_list<Block, S>& free_blocks, Block* block) noexcept
+{
+    // erased slots of an empty block must not be handed out again
+    if (block->free_list_head_ != free_blocks.NO_FREE)
+        free_blocks.unlink_block(block);
+
+    BlockPtr owned{ block->prev != nullptr ? std::move(block->prev->next) : std::move(first) };
+
+    if (block->next != nullptr)
+        block->next->prev = block->prev;
+    else
+        last = block->prev;
+
+    if (block->prev != nullptr)
+        block->prev->next = std::move(block->next);
+    else
+        first = std::move(block->next);
+
+    block->prev = nullptr;
+    block->free_list_head_ = free_blocks.NO_FREE;
+    block->free_runs_ = 0;
+    block->highest_untouched_ = 0;
+    return owned;
+}
+
+    /* --- Forward Declared Functions --- */
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::on_emplace(Block* block, size_t idx, links_type links) noexcept
+{
+    // the rest of the run moves up one slot
+    const size_t old_skip{ block->skipfield_[idx] };
+    block->skipfield_[idx] = 0;
+
+    if (old_skip > 1) [[likely]]
+    {
+        const auto new_skip = static_cast<S>(old_skip - 1);
+        block->skipfield_[idx+1] = new_skip;
+        block->skipfield_[idx+new_skip] = new_skip;
+        relink_free_run(block, idx+1, links);
+    }
+    else
+    {
+        unlink_free_run(block, links);
+    }
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::on_erase(Block* block, size_t idx, size_t count) noexcept
+{
+    S* skip{ block->skipfield_ };
+    const size_t after{ idx + count };
+
+    // neighbours with a non zero skip belong to erased runs we coalesce with
+    const size_t left_gap{ idx > 0 ? skip[idx-1] : size_t{ 0 } };
+    const size_t right_gap{ after < block->highest_untouched_ ? skip[after] : size_t{ 0 } };
+
+    const auto new_gap = static_cast<S>(left_gap + count + right_gap);
+    skip[idx-left_gap] = new_gap;
+    skip[after+right_gap-1] = new_gap;
+
+    // the free list holds one entry per run, keyed by the first slot of the run
+    if (left_gap == 0 && right_gap == 0)
+        push_free_run(block, idx);
+    else if (left_gap == 0)
+        relink_free_run(block, idx, block->links(after));
+    else if (right_gap > 0)
+        unlink_free_run(block, block->links(after));
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::push_free_run(Block* block, size_t idx) noexcept
+{
+    const auto new_head = static_cast<S>(idx);
+    block->set_links(idx, links_type{ NO_FREE, block->free_list_head_ });
+    ++block->free_runs_;
+
+    if (block->free_list_head_ != NO_FREE)
+        block->links(block->free_list_head_).prev = new_head;
+    else
+        link_block(block);
+    block->free_list_head_ = new_head;
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::unlink_free_run(Block* block, links_type links) noexcept
+{
+    --block->free_runs_;
+    if (links.next != NO_FREE)
+        block->links(links.next).prev = links.prev;
+
+    if (links.prev != NO_FREE)
+    {
+        block->links(links.prev).next = links.next;
+        return;
+    }
+
+    block->free_list_head_ = links.next;
+    if (block->free_list_head_ != NO_FREE)
+        return;
+
+    // last run of the block is gone
+    unlink_block(block);
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::relink_free_run(Block* block, size_t new_idx, links_type links) noexcept
+{
+    const auto new_node = static_cast<S>(new_idx);
+    block->set_links(new_idx, links);
+
+    if (links.next != NO_FREE)
+        block->links(links.next).prev = new_node;
+
+    if (links.prev != NO_FREE)
+        block->links(links.prev).next = new_node;
+    else
+        block->free_list_head_ = new_node;
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::link_block(Block* block) noexcept
+{
+    // erasure usually sweeps forward so appending is the common case
+    Block* after{ last_ };
+    while (after != nullptr && after->serial_ > block->serial_)
+        after = after->prev_with_free_;
+
+    block->prev_with_free_ = after;
+    block->next_with_free_ = after != nullptr ? after->next_with_free_ : first_;
+
+    if (block->next_with_free_ != nullptr)
+        block->next_with_free_->prev_with_free_ = block;
+    else
+        last_ = block;
+
+    if (after != nullptr)
+        after->next_with_free_ = block;
+    else
+        first_ = block;
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::unlink_block(Block* block) noexcept
+{
+    if (block->next_with_free_ != nullptr)
+        block->next_with_free_->prev_with_free_ = block->prev_with_free_;
+    else
+        last_ = block->prev_with_free_;
+
+    if (block->prev_with_free_ != nullptr)
+        block->prev_with_free_->next_with_free_ = block->next_with_free_;
+    else
+        first_ = block->next_with_free_;
+
+    block->next_with_free_ = nullptr;
+    block->prev_with_free_ = nullptr;
+}
+
+template<typename Block, hive_skipfield S>
+void free_block_list<Block, S>::splice(free_block_list& other) noexcept
+{
+    if (other.first_ == nullptr)
+        return;
+
+    other.first_->prev_with_free_ = last_;
+    if (last_ != nullptr)
+        last_->next_with_free_ = other.first_;
+    else
+        first_ = other.first_;
+    last_ = other.last_;
+    other.reset();
+}
+
+}
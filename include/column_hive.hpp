@@ -0,0 +1,577 @@
+#pragma once
+
+#include "block_list.hpp"
+#include "skipfield_scan.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Hive of rows whose fields are stored column by column. Each block holds one contiguous
+// array per field, and all arrays share the block's skipfield and free list, so a row
+// keeps its slot in every column until it is erased. The skipfield encoding is the same
+// as hive's, so the same kernels find the runs of active rows. Loops that read only a
+// few fields go through for_each_segment, which yields a span per requested column.
+//
+// The columns come last, so the allocator and skipfield come first and column_hive<Ts...>
+// names the usual choice. Blocks come from Allocator, rebound as in hive; the fields
+// themselves are constructed in place.
+template <typename Allocator, hive_skipfield Skipfield, typename... Ts>
+class basic_column_hive
+{
+    static_assert(sizeof...(Ts) > 0, "A column hive needs at least one column.");
+
+public:
+    using skipfield_type = Skipfield;
+    using value_type = std::tuple<Ts...>;
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+
+    template<size_t I>
+    using column_type = std::tuple_element_t<I, value_type>;
+
+    static constexpr size_t COLUMN_COUNT{ sizeof...(Ts) };
+    static constexpr size_t MAX_BLOCK_CAPACITY{ std::numeric_limits<skipfield_type>::max() };
+
+private:
+    struct Block;
+    struct BlockUnit;
+
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using BlockAllocator = typename AllocTraits::template rebind_alloc<BlockUnit>;
+    using BlockAllocTraits = std::allocator_traits<BlockAllocator>;
+
+    // Links of a block's free list, one entry per slot, read at the head of each erased run
+    using FreeLinks = hive_detail::free_links<Skipfield>;
+    using FreeBlocks = hive_detail::free_block_list<Block, Skipfield>;
+    static constexpr Skipfield NO_FREE{ FreeBlocks::NO_FREE };
+
+    [[nodiscard]] static size_t block_units(size_t capacity) noexcept;
+    using BlockDeleter = hive_detail::block_deleter<Block, BlockAllocator, &block_units>;
+    using BlockPtr = std::unique_ptr<Block, BlockDeleter>;
+
+    static constexpr size_t INITIAL_CAPACITY{ std::min<size_t>(16, MAX_BLOCK_CAPACITY) };
+    static constexpr bool TRIVIAL_DESTROY{ (std::is_trivially_destructible_v<Ts> && ...) };
+
+    // skipfield_[i] == 0 means row i is active, otherwise the first and last slot of an
+    // erased run hold the length of the run
+    struct Block
+    {
+        size_t             capacity_{ };
+        std::tuple<Ts*...> columns_{ };
+        Skipfield*         skipfield_{ nullptr };
+        FreeLinks*         links_{ nullptr };
+
+        BlockPtr next;
+        Block*   prev{ nullptr };
+
+        // blocks with erased slots form their own list, see hive_detail::free_block_list
+        Block*    next_with_free_{ nullptr };
+        Block*    prev_with_free_{ nullptr };
+        Skipfield free_list_head_{ NO_FREE };
+        size_t    free_runs_{ };
+
+        size_t active_count_{ };
+        size_t highest_untouched_{ };
+
+        // position in the chain, increases from first_block_ to last_block_
+        size_t serial_{ };
+
+        [[nodiscard]] FreeLinks& links(size_t idx) noexcept { return links_[idx]; }
+        void set_links(size_t idx, FreeLinks links) noexcept { links_[idx] = links; }
+    };
+
+    // Every column starts on its own cache line so column loops load whole lines.
+    // A block is one allocation laid out as [Block | column 0 | ... | skipfield | links].
+    static constexpr size_t BLOCK_ALIGN{ std::max({ size_t{ 64 }, alignof(Block), alignof(Ts)... }) };
+    struct alignas(BLOCK_ALIGN) BlockUnit
+    {
+        std::byte bytes[BLOCK_ALIGN];
+    };
+
+    struct Layout
+    {
+        std::array<size_t, COLUMN_COUNT> columns;
+        size_t skipfield;
+        size_t links;
+        size_t units;
+    };
+
+    [[nodiscard]] static constexpr size_t align_up(size_t offset, size_t align) noexcept
+    {
+        return (offset + align - 1) / align * align;
+    }
+
+    [[nodiscard]] static constexpr Layout layout(size_t capacity) noexcept
+    {
+        Layout result{ };
+        size_t offset{ sizeof(Block) };
+        size_t next_column{ };
+        ((offset = align_up(offset, BLOCK_ALIGN),
+          result.columns[next_column++] = offset,
+          offset += capacity * sizeof(Ts)), ...);
+
+        result.skipfield = align_up(offset, alignof(Skipfield));
+        result.links = align_up(result.skipfield + capacity * sizeof(Skipfield), alignof(FreeLinks));
+        result.units = align_up(result.links + capacity * sizeof(FreeLinks), BLOCK_ALIGN) / BLOCK_ALIGN;
+        return result;
+    }
+
+    template<size_t I>
+    [[nodiscard]] static column_type<I>* column(const Block* block) noexcept { return std::get<I>(block->columns_); }
+
+
+    /* --- Iterator Class --- */
+public:
+
+    // Forward iterator over rows, dereferencing gives a tuple of references into the columns
+    template<bool Const>
+    class base_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using iterator_concept  = std::forward_iterator_tag;
+        using value_type        = basic_column_hive::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<Const, const_reference, basic_column_hive::reference>;
+
+        base_iterator() = default;
+
+        // iterator converts to const_iterator
+        template<bool OtherConst>
+            requires (Const && !OtherConst)
+        base_iterator(const base_iterator<OtherConst>& other) noexcept
+            : block_(other.block_),
+              idx_(other.idx_)
+        { }
+
+        [[nodiscard]] reference operator*() const noexcept
+        {
+            return [this]<size_t... Is>(std::index_sequence<Is...>)
+            {
+                return reference{ column<Is>(block_)[idx_]... };
+            }(std::index_sequence_for<Ts...>{ });
+        }
+
+        // a single field of the row
+        template<size_t I>
+        [[nodiscard]] auto& get() const noexcept
+        {
+            if constexpr (Const)
+                return std::as_const(column<I>(block_)[idx_]);
+            else
+                return column<I>(block_)[idx_];
+        }
+
+        base_iterator& operator++() noexcept
+        {
+            ++idx_;
+            skip_erased();
+            return *this;
+        }
+
+        base_iterator operator++(int) noexcept
+        {
+            base_iterator tmp{ *this };
+            ++*this;
+            return tmp;
+        }
+
+        template<bool OtherConst>
+        [[nodiscard]] bool operator==(const base_iterator<OtherConst>& other) const noexcept
+        {
+            return block_ == other.block_ && idx_ == other.idx_;
+        }
+
+    private:
+        friend class basic_column_hive;
+        template<bool> friend class base_iterator;
+
+        Block* block_{ nullptr };
+        size_t idx_{ };
+
+        // idx must be active, the head of an erased run or the end of the block
+        base_iterator(Block* block, size_t idx) noexcept
+            : block_(block),
+              idx_(idx)
+        {
+            skip_erased();
+        }
+
+        void skip_erased() noexcept
+        {
+            while (block_ != nullptr)
+            {
+                if (idx_ < block_->highest_untouched_)
+                {
+                    idx_ += block_->skipfield_[idx_];
+                    if (idx_ < block_->highest_untouched_)
+                        return;
+                }
+                block_ = block_->next.get();
+                idx_ = 0;
+            }
+        }
+    };
+
+    using iterator = base_iterator<false>;
+    using const_iterator = base_iterator<true>;
+
+
+    /* --- Member Variables --- */
+private:
+    BlockPtr first_block_{ nullptr };
+    Block*   last_block_{ nullptr };
+
+    // blocks with erased slots, emplace takes the lowest one before touching new slots
+    FreeBlocks free_blocks_;
+
+    // an emptied block is kept for reuse so inserting and erasing one row does not thrash
+    BlockPtr spare_block_{ nullptr };
+
+    Allocator allocator_{ };
+
+    size_t size_{ };
+    size_t capacity_{ };
+    size_t next_block_capacity_{ INITIAL_CAPACITY };
+
+
+    /* --- Special Member Functions --- */
+public:
+    explicit basic_column_hive(const Allocator& alloc = Allocator())
+        : allocator_(alloc)
+    { }
+
+    basic_column_hive(const basic_column_hive& other)
+        : basic_column_hive(other, AllocTraits::select_on_container_copy_construction(other.allocator_))
+    { }
+
+    // the rows are copied into a constructed hive, so rows copied before one that throws
+    // are freed by its destructor
+    basic_column_hive(const basic_column_hive& other, const Allocator& alloc)
+        : basic_column_hive(alloc)
+    {
+        for (const_reference row : other)
+            std::apply([this](const Ts&... fields) { emplace(fields...); }, row);
+    }
+
+    basic_column_hive& operator=(const basic_column_hive& other)
+    {
+        if (this != &other)
+            hive_detail::copy_assign(*this, allocator_, other, other.allocator_);
+        return *this;
+    }
+
+    basic_column_hive(basic_column_hive&& other) noexcept
+        : allocator_(other.allocator_)
+    {
+        swap_blocks(other);
+    }
+
+    basic_column_hive& operator=(basic_column_hive&& other) noexcept(hive_detail::always_steals_blocks<Allocator>)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        hive_detail::move_assign(allocator_, other.allocator_, true,
+                                 [&] { swap_blocks(other); },
+                                 [&] { move_rows_from(other); });
+        return *this;
+    }
+
+    ~basic_column_hive() { clear(); }
+
+    [[nodiscard]] Allocator get_allocator() const noexcept { return allocator_; }
+
+    void swap(basic_column_hive& other) noexcept
+    {
+        swap_blocks(other);
+        hive_detail::swap_allocators(allocator_, other.allocator_);
+    }
+
+    friend void swap(basic_column_hive& a, basic_column_hive& b) noexcept { a.swap(b); }
+
+
+    /* --- Capacity and Iteration --- */
+    [[nodiscard]] bool is_empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+    // empty blocks are freed, so the first block always holds an active row
+    [[nodiscard]] iterator begin() noexcept { return iterator{ first_block_.get(), 0 }; }
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ first_block_.get(), 0 }; }
+    [[nodiscard]] iterator end() noexcept { return iterator{ }; }
+    [[nodiscard]] const_iterator end() const noexcept { return const_iterator{ }; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    // Calls func with one span per listed column for every run of active rows, e.g.
+    // for_each_segment<0, 1>([](std::span<Vec3> pos, std::span<Vec3> vel) { ... }).
+    // No columns listed means all of them. Spans of one run have the same size.
+    template<size_t... Is, typename Func>
+    void for_each_segment(Func func)
+    {
+        for_each_run([&func](Block* block, size_t first, size_t last)
+        {
+            call_with_spans<basic_column_hive, Is...>(func, block, first, last);
+        });
+    }
+    template<size_t... Is, typename Func>
+    void for_each_segment(Func func) const
+    {
+        for_each_run([&func](Block* block, size_t first, size_t last)
+        {
+            call_with_spans<const basic_column_hive, Is...>(func, block, first, last);
+        });
+    }
+
+
+    /* --- Modifiers --- */
+    // One argument per column, each column's element is constructed from its argument
+    template<typename... Args>
+        requires (sizeof...(Args) == sizeof...(Ts) && (std::is_constructible_v<Ts, Args> && ...))
+    iterator emplace(Args&&... args);
+
+    // Returns the iterator following the erased row
+    iterator erase(const_iterator pos);
+
+    void clear() noexcept;
+
+private:
+    void swap_blocks(basic_column_hive& other) noexcept
+    {
+        using std::swap;
+        swap(first_block_, other.first_block_);
+        swap(last_block_, other.last_block_);
+        free_blocks_.swap(other.free_blocks_);
+        swap(spare_block_, other.spare_block_);
+        swap(size_, other.size_);
+        swap(capacity_, other.capacity_);
+        swap(next_block_capacity_, other.next_block_capacity_);
+    }
+
+    void move_rows_from(basic_column_hive& other)
+    {
+        for (reference row : other)
+            std::apply([this](Ts&... fields) { emplace(std::move(fields)...); }, row);
+        other.clear();
+    }
+
+    template<typename Func>
+    void for_each_run(Func&& func) const
+    {
+        for (Block* block = first_block_.get(); block != nullptr; block = block->next.get())
+        {
+            hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_,
+                                             [&](size_t first, size_t last) { func(block, first, last); });
+        }
+    }
+
+    template<typename Self, size_t... Is, typename Func>
+    static void call_with_spans(Func& func, Block* block, size_t first, size_t last)
+    {
+        if constexpr (sizeof...(Is) == 0)
+        {
+            [&]<size_t... All>(std::index_sequence<All...>)
+            {
+                call_with_spans<Self, All...>(func, block, first, last);
+            }(std::index_sequence_for<Ts...>{ });
+        }
+        else
+        {
+            const size_t count{ last - first };
+            if constexpr (std::is_const_v<Self>)
+                func(std::span<const column_type<Is>>{ column<Is>(block) + first, count }...);
+            else
+                func(std::span<column_type<Is>>{ column<Is>(block) + first, count }...);
+        }
+    }
+
+    // constructs the columns in order, destroying the finished ones if a later one throws
+    template<size_t I, typename Arg, typename... Rest>
+    static void construct_columns(Block* block, size_t idx, Arg&& arg, Rest&&... rest)
+    {
+        std::construct_at(column<I>(block) + idx, std::forward<Arg>(arg));
+        if constexpr (sizeof...(Rest) > 0)
+        {
+            try
+            {
+                construct_columns<I + 1>(block, idx, std::forward<Rest>(rest)...);
+            }
+            catch (...)
+            {
+                std::destroy_at(column<I>(block) + idx);
+                throw;
+            }
+        }
+    }
+
+    static void destroy_row(Block* block, size_t idx) noexcept
+    {
+        [&]<size_t... Is>(std::index_sequence<Is...>)
+        {
+            (std::destroy_at(column<Is>(block) + idx), ...);
+        }(std::index_sequence_for<Ts...>{ });
+    }
+
+    void add_block();
+    void release_block(Block* block) noexcept;
+};
+
+template<typename... Ts>
+using column_hive = basic_column_hive<std::allocator<std::tuple<Ts...>>, std::uint16_t, Ts...>;
+
+namespace pmr
+{
+    template<typename... Ts>
+    using column_hive = basic_column_hive<std::pmr::polymorphic_allocator<std::tuple<Ts...>>, std::uint16_t, Ts...>;
+}
+
+
+    /* --- Modifiers --- */
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+template<typename... Args>
+    requires (sizeof...(Args) == sizeof...(Ts) && (std::is_constructible_v<Ts, Args> && ...))
+typename basic_column_hive<Allocator, Skipfield, Ts...>::iterator
+basic_column_hive<Allocator, Skipfield, Ts...>::emplace(Args&&... args)
+{
+    Block* block{ free_blocks_.first() };
+    size_t idx{ };
+
+    if (block != nullptr)
+    {
+        idx = block->free_list_head_;
+        construct_columns<0>(block, idx, std::forward<Args>(args)...);
+        free_blocks_.on_emplace(block, idx, block->links_[idx]);
+    }
+    else
+    {
+        if (last_block_ == nullptr || last_block_->highest_untouched_ == last_block_->capacity_)
+            add_block();
+        block = last_block_;
+        idx = block->highest_untouched_;
+
+        construct_columns<0>(block, idx, std::forward<Args>(args)...);
+        block->skipfield_[idx] = 0;
+        ++block->highest_untouched_;
+    }
+
+    ++block->active_count_;
+    ++size_;
+    return iterator{ block, idx };
+}
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+typename basic_column_hive<Allocator, Skipfield, Ts...>::iterator
+basic_column_hive<Allocator, Skipfield, Ts...>::erase(const_iterator pos)
+{
+    Block* block{ pos.block_ };
+    const size_t idx{ pos.idx_ };
+    if (block == nullptr || idx >= block->highest_untouched_ || block->skipfield_[idx] != 0)
+        return end();
+
+    // the following row is found before the skipfield around idx changes, a block this
+    // erase empties has no row after idx so next is already past it
+    const iterator next{ block, idx + 1 };
+
+    if constexpr (!TRIVIAL_DESTROY)
+        destroy_row(block, idx);
+    --size_;
+
+    if (--block->active_count_ == 0)
+        release_block(block);
+    else
+        free_blocks_.on_erase(block, idx);
+    return next;
+}
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+void basic_column_hive<Allocator, Skipfield, Ts...>::clear() noexcept
+{
+    if constexpr (!TRIVIAL_DESTROY)
+    {
+        for_each_run([](Block* block, size_t first, size_t last)
+        {
+            for (; first < last; ++first)
+                destroy_row(block, first);
+        });
+    }
+
+    // unlink iteratively so long chains do not recurse through the deleters, and free
+    // each block only after its next pointer, deleter included, has been moved out
+    while (first_block_ != nullptr)
+    {
+        BlockPtr doomed{ std::move(first_block_) };
+        first_block_ = std::move(doomed->next);
+    }
+    spare_block_.reset();
+
+    last_block_ = nullptr;
+    free_blocks_.reset();
+    size_ = 0;
+    capacity_ = 0;
+    next_block_capacity_ = INITIAL_CAPACITY;
+}
+
+
+    /* --- Blocks --- */
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+size_t basic_column_hive<Allocator, Skipfield, Ts...>::block_units(size_t capacity) noexcept
+{
+    return layout(capacity).units;
+}
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+void basic_column_hive<Allocator, Skipfield, Ts...>::add_block()
+{
+    BlockPtr new_block{ std::move(spare_block_) };
+    if (new_block == nullptr)
+    {
+        const size_t block_capacity{ next_block_capacity_ };
+        const Layout block_layout{ layout(block_capacity) };
+        BlockAllocator block_alloc{ allocator_ };
+        std::byte* bytes{ reinterpret_cast<std::byte*>(BlockAllocTraits::allocate(block_alloc, block_layout.units)) };
+
+        new_block = BlockPtr{ std::construct_at(reinterpret_cast<Block*>(bytes)), BlockDeleter{ block_alloc } };
+        new_block->capacity_ = block_capacity;
+        [&]<size_t... Is>(std::index_sequence<Is...>)
+        {
+            new_block->columns_ = std::tuple<Ts*...>{ reinterpret_cast<Ts*>(bytes + block_layout.columns[Is])... };
+        }(std::index_sequence_for<Ts...>{ });
+        new_block->skipfield_ = reinterpret_cast<Skipfield*>(bytes + block_layout.skipfield);
+        new_block->links_ = reinterpret_cast<FreeLinks*>(bytes + block_layout.links);
+
+        capacity_ += block_capacity;
+        next_block_capacity_ = std::min(block_capacity * 2, MAX_BLOCK_CAPACITY);
+    }
+
+    hive_detail::append_block(first_block_, last_block_, std::move(new_block));
+}
+
+template<typename Allocator, hive_skipfield Skipfield, typename... Ts>
+void basic_column_hive<Allocator, Skipfield, Ts...>::release_block(Block* block) noexcept
+{
+    BlockPtr owned{ hive_detail::detach_block(first_block_, last_block_, free_blocks_, block) };
+
+    if (spare_block_ == nullptr)
+    {
+        spare_block_ = std::move(owned);
+    }
+    else
+    {
+        capacity_ -= block->capacity_;
+        owned.reset();
+    }
+}
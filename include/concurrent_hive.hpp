@@ -0,0 +1,196 @@
+#pragma once
+
+#include "hive.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Sharded hive for concurrent emplace/erase. Every thread inserts into the shard it maps
+// to, so threads get their own active block and free lists and only contend when there
+// are more threads than shards. Erasing an element owned by another shard is queued and
+// carried out by that shard's next emplace/erase (or by collect()). Elements never move.
+template <typename T, typename Allocator = std::allocator<T>, hive_skipfield Skipfield = std::uint16_t>
+class concurrent_hive
+{
+public:
+    using hive_type = hive<T, Allocator, Skipfield>;
+
+    // Returned by emplace, identifies the element and the shard that owns it
+    class handle
+    {
+    public:
+        handle() = default;
+
+        [[nodiscard]] T& operator*() const { return *itr_; }
+        [[nodiscard]] T* operator->() const { return &*itr_; }
+        [[nodiscard]] T* get() const { return &*itr_; }
+        [[nodiscard]] size_t shard() const noexcept { return shard_; }
+
+    private:
+        friend class concurrent_hive;
+        size_t shard_{ };
+        typename hive_type::iterator itr_{ };
+
+        handle(size_t shard, typename hive_type::iterator itr)
+            : shard_(shard),
+              itr_(itr)
+        { }
+    };
+
+private:
+    // padded so shards written by different threads do not share cache lines
+    struct alignas(64) Shard
+    {
+        std::mutex mutex_;
+        hive_type hive_;
+        std::atomic<size_t> size_{ };
+
+        // erasures handed over by other threads
+        std::mutex pending_mutex_;
+        std::vector<typename hive_type::iterator> pending_erase_;
+        std::atomic<bool> has_pending_{ false };
+
+        explicit Shard(const Allocator& alloc)
+            : hive_(alloc)
+        { }
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    /* --- Concurrent Hive Special Member Functions --- */
+public:
+    explicit concurrent_hive(size_t shard_count = std::max<size_t>(1, std::thread::hardware_concurrency()),
+                             const Allocator& alloc = Allocator())
+    {
+        shards_.reserve(std::max<size_t>(1, shard_count));
+        for (size_t i{}; i<std::max<size_t>(1, shard_count); ++i)
+            shards_.push_back(std::make_unique<Shard>(alloc));
+    }
+
+    concurrent_hive(const concurrent_hive&) = delete;
+    concurrent_hive& operator=(const concurrent_hive&) = delete;
+
+    [[nodiscard]] size_t shard_count() const noexcept { return shards_.size(); }
+
+    // Sum of the shard sizes, approximate while other threads are writing
+    [[nodiscard]] size_t size() const noexcept
+    {
+        size_t total{ };
+        for (const auto& shard : shards_)
+            total += shard->size_.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    [[nodiscard]] bool is_empty() const noexcept { return size() == 0; }
+
+    template<typename... Args>
+    handle emplace(Args&&... args);
+
+    // Erases directly when the calling thread maps to the owning shard, otherwise defers.
+    // Each handle must be erased at most once.
+    void erase(handle h);
+
+    // Carries out every deferred erasure
+    void collect();
+
+    // Visits every element, locking one shard at a time
+    template<typename Func>
+    void for_each(Func func);
+
+private:
+    [[nodiscard]] size_t local_shard() const noexcept;
+    static void drain_pending(Shard& shard);
+};
+
+    /* --- Forward Declared Functions --- */
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+size_t concurrent_hive<T, Allocator, Skipfield>::local_shard() const noexcept
+{
+    // ids are handed out round robin on first use, so threads spread evenly over shards
+    static std::atomic<size_t> next_thread_id{ };
+    thread_local const size_t thread_id{ next_thread_id.fetch_add(1, std::memory_order_relaxed) };
+    return thread_id % shards_.size();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+template<typename... Args>
+typename concurrent_hive<T, Allocator, Skipfield>::handle
+concurrent_hive<T, Allocator, Skipfield>::emplace(Args&&... args)
+{
+    const size_t shard_idx{ local_shard() };
+    Shard& shard{ *shards_[shard_idx] };
+
+    std::scoped_lock lock{ shard.mutex_ };
+    drain_pending(shard);
+
+    auto itr = shard.hive_.emplace(std::forward<Args>(args)...);
+    shard.size_.store(shard.hive_.size(), std::memory_order_relaxed);
+    return handle(shard_idx, itr);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+void concurrent_hive<T, Allocator, Skipfield>::erase(handle h)
+{
+    Shard& shard{ *shards_[h.shard_] };
+
+    if (h.shard_ == local_shard())
+    {
+        std::scoped_lock lock{ shard.mutex_ };
+        drain_pending(shard);
+        shard.hive_.erase(h.itr_);
+        shard.size_.store(shard.hive_.size(), std::memory_order_relaxed);
+        return;
+    }
+
+    std::scoped_lock lock{ shard.pending_mutex_ };
+    shard.pending_erase_.push_back(h.itr_);
+    shard.has_pending_.store(true, std::memory_order_release);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+void concurrent_hive<T, Allocator, Skipfield>::collect()
+{
+    for (auto& shard : shards_)
+    {
+        std::scoped_lock lock{ shard->mutex_ };
+        drain_pending(*shard);
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+template<typename Func>
+void concurrent_hive<T, Allocator, Skipfield>::for_each(Func func)
+{
+    for (auto& shard : shards_)
+    {
+        std::scoped_lock lock{ shard->mutex_ };
+        drain_pending(*shard);
+        for (auto& elem : shard->hive_)
+            func(elem);
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+void concurrent_hive<T, Allocator, Skipfield>::drain_pending(Shard& shard)
+{
+    // caller holds shard.mutex_
+    if (!shard.has_pending_.load(std::memory_order_acquire))
+        return;
+
+    std::vector<typename hive_type::iterator> pending;
+    {
+        std::scoped_lock lock{ shard.pending_mutex_ };
+        pending.swap(shard.pending_erase_);
+        shard.has_pending_.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto itr : pending)
+        shard.hive_.erase(itr);
+    shard.size_.store(shard.hive_.size(), std::memory_order_relaxed);
+}
@@ -1,80 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "block_list.hpp"
+#include "skipfield_scan.hpp"
+
+// Minimum and maximum number of elements per block, as in std::hive_limits
+struct hive_limits
+{
+    size_t min;
+    size_t max;
+
+    constexpr hive_limits(size_t minimum, size_t maximum) noexcept
+        : min(minimum),
+          max(maximum)
+    { }
+};
+
+// Layout snapshot returned by hive::stats()
+struct hive_block_stats
+{
+    size_t capacity;
+    size_t active;
+    size_t highest_untouched;   // slots past this were never used
+    size_t erased_runs;
+};
+
+struct hive_stats
+{
+    size_t size{ };
+    size_t capacity{ };
+    size_t block_count{ };
+    size_t spare_block_count{ };
+
+    std::vector<hive_block_stats> blocks;
+
+    // erased_run_histogram[i] counts erased runs with length in [2^i, 2^(i+1))
+    std::vector<size_t> erased_run_histogram;
+    size_t erased_slots{ };
+    size_t free_list_length{ };     // erased runs on the per block free lists
+    size_t blocks_with_free{ };
+
+    // blocks, slots including Element and skipfield overhead, and bookkeeping
+    size_t bytes_allocated{ };
+};
+
+// Event counters, only kept when HIVE_COUNTERS is defined, read with hive::counters()
+struct hive_counters
+{
+    size_t emplaced{ };
+    size_t erased{ };
+    size_t free_list_hits{ };   // elements constructed in an erased slot
+    size_t blocks_allocated{ };
+    size_t spare_block_reuses{ };
+};
+
+#ifdef HIVE_COUNTERS
+inline constexpr bool hive_counters_enabled{ true };
+#else
+inline constexpr bool hive_counters_enabled{ false };
+#endif
+
+// Persistent workers for hive's parallel traversals, so a per tick update does not pay
+// for thread creation. run() hands out task indices to the workers and to the calling
+// thread, which keeps claiming tasks of its own batch, so several callers can share one
+// pool and a pool without workers runs everything inline.
+class hive_thread_pool
+{
+public:
+    explicit hive_thread_pool(size_t workers = std::max<unsigned>(1, std::thread::hardware_concurrency()) - 1)
+    {
+        workers_.reserve(workers);
+        for (size_t i{}; i<workers; ++i)
+            workers_.emplace_back([this] { work(); });
+    }
+
+    hive_thread_pool(const hive_thread_pool&) = delete;
+    hive_thread_pool& operator=(const hive_thread_pool&) = delete;
+
+    ~hive_thread_pool()
+    {
+        {
+            std::scoped_lock lock{ mutex_ };
+            stopping_ = true;
+        }
+        wake_.notify_all();
+    }
+
+    [[nodiscard]] size_t worker_count() const noexcept { return workers_.size(); }
+
+    // Calls task(i) for every i in [0, count) and returns once all calls have finished.
+    // task must not throw.
+    template<typename Task>
+    void run(size_t count, Task& task);
 
-template <typename T, typename Allocator = std::allocator<T>>
+    // Shared by every traversal that is not given a pool, created on first use
+    [[nodiscard]] static hive_thread_pool& shared()
+    {
+        static hive_thread_pool pool;
+        return pool;
+    }
+
+private:
+    struct Batch
+    {
+        void (*invoke)(void*, size_t);
+        void* task;
+        size_t count;
+        size_t next;       // next unclaimed index, guarded by mutex_
+        size_t finished;   // guarded by mutex_
+        std::condition_variable done;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Batch*> batches_;
+    bool stopping_{ false };
+    std::vector<std::jthread> workers_;
+
+    // claims the next index of batch, retiring the batch from the queue once all are claimed
+    size_t claim(Batch& batch)
+    {
+        const size_t idx{ batch.next++ };
+        if (batch.next == batch.count)
+            std::erase(batches_, &batch);
+        return idx;
+    }
+
+    void finish(Batch& batch)
+    {
+        std::scoped_lock lock{ mutex_ };
+        if (++batch.finished == batch.count)
+            batch.done.notify_all();
+    }
+
+    void work()
+    {
+        std::unique_lock lock{ mutex_ };
+        for (;;)
+        {
+            wake_.wait(lock, [this] { return stopping_ || !batches_.empty(); });
+            if (batches_.empty())
+                return;
+
+            Batch& batch{ *batches_.front() };
+            const size_t idx{ claim(batch) };
+            lock.unlock();
+            batch.invoke(batch.task, idx);
+            finish(batch);
+            lock.lock();
+        }
+    }
+};
+
+template<typename Task>
+void hive_thread_pool::run(size_t count, Task& task)
+{
+    if (count == 0)
+        return;
+    if (count == 1 || workers_.empty())
+    {
+        for (size_t i{}; i<count; ++i)
+            task(i);
+        return;
+    }
+
+    Batch batch{ [](void* erased, size_t i) { (*static_cast<Task*>(erased))(i); }, &task, count, 0, 0, { } };
+    std::unique_lock lock{ mutex_ };
+    batches_.push_back(&batch);
+    wake_.notify_all();
+
+    while (batch.next < batch.count)
+    {
+        const size_t idx{ claim(batch) };
+        lock.unlock();
+        task(idx);
+        lock.lock();
+        ++batch.finished;
+    }
+    batch.done.wait(lock, [&batch] { return batch.finished == batch.count; });
+}
+
+// Generational hives keep a per-slot generation next to the skipfield so elements can be
+// referenced through compact handles that detect reuse of their slot.
+// InlineCapacity > 0 embeds the first block, with that many slots, in the hive object,
+// see small_hive.
+template <typename T, typename Allocator = std::allocator<T>, hive_skipfield Skipfield = std::uint16_t,
+          bool Generational = false, size_t InlineCapacity = 0>
 class hive
 {
 private:
-    struct Element;
+    union Element;
     struct Block;
-    struct BlockDeleter;
 
     // Allocator for T objects inside elements inside blocks
     using AllocTraits = std::allocator_traits<Allocator>;
 
-    // Allocator for blocks
-    using BlockAllocator = typename AllocTraits::template rebind_alloc<Block>;
+    // Allocator for blocks, each block is one allocation of BlockUnits
+    struct BlockUnit;
+    using BlockAllocator = typename AllocTraits::template rebind_alloc<BlockUnit>;
     using BlockAllocTraits = std::allocator_traits<BlockAllocator>;
 
-    //Allocator for elements inside blocks
-    using ElementAllocator = typename AllocTraits::template rebind_alloc<Element>;
-    using ElementAllocTraits = std::allocator_traits<ElementAllocator>;
-
-    // Elements encapsulate data
-    struct Element
+    struct no_relocate
     {
-        size_t skip{ 1 };
+        void operator()(T*, T*) const noexcept { }
+    };
 
-        Block* parent{ nullptr };
-        
-        // next free is for the free list, either holding data or on free list if erased
-        union
-        {
-            T data;
-            Element* next_free_{ nullptr };
-        };
+    using FreeBlocks = hive_detail::free_block_list<Block, Skipfield>;
+    static constexpr Skipfield NO_FREE{ FreeBlocks::NO_FREE };
 
-        Element()
-            : next_free_(nullptr)
-        { }
+    // Lifecycle fast paths, only taken when the allocator does not customize construct
+    // or destroy. Destroying then does nothing, so clear() and ~hive() skip the element
+    // scan, and copies into slots are plain memory writes.
+    static constexpr bool TRIVIAL_DESTROY{ std::is_trivially_destructible_v<T> &&
+                                           !requires (Allocator& a, T* p) { a.destroy(p); } };
+    static constexpr bool TRIVIAL_COPY{ std::is_trivially_copyable_v<T> &&
+                                        !requires (Allocator& a, T* p, const T& v) { a.construct(p, v); } };
+
+    // sort() moves values up to this size out to a contiguous buffer, past it sorting
+    // pointers and permuting in place is faster
+    static constexpr bool SORT_BY_MOVE{ std::is_nothrow_move_constructible_v<T> &&
+                                        std::is_nothrow_move_assignable_v<T> && sizeof(T) <= 256 };
+
+public:
+    static constexpr size_t MAX_BLOCK_CAPACITY{ std::numeric_limits<Skipfield>::max() };
+
+private:
+    // Links of a block's free list, stored in the first slot of each erased run
+    using FreeLinks = hive_detail::free_links<Skipfield>;
+
+    // BlockUnits in a block of capacity slots, the deleter frees that many
+    [[nodiscard]] static size_t block_units(size_t capacity) noexcept;
+    using BlockDeleter = hive_detail::block_deleter<Block, BlockAllocator, &block_units>;
 
-        ~Element() {}
+    // Elements are either holding data or, at the head of an erased run, the free list links
+    union Element
+    {
+        T data;
+        FreeLinks free_;
+
+        Element() noexcept { }
+        ~Element() { }
     };
 
     // Blocks encapsulate elements
+    // skipfield_[i] == 0 means elements_[i] is active, otherwise the first and
+    // last slot of an erased run hold the length of the run
     struct Block
     {
-        size_t   capacity_{ };
-        Element* elements_{ nullptr };
+        size_t     capacity_{ };
+        Element*   elements_{ nullptr };
+        Skipfield* skipfield_{ nullptr };
 
         std::unique_ptr<Block, BlockDeleter> next;
         Block* prev{ nullptr };
 
+        // blocks with erased slots form their own list, see hive_detail::free_block_list
+        Block* next_with_free_{ nullptr };
+        Block* prev_with_free_{ nullptr };
+        Skipfield free_list_head_{ NO_FREE };
+        size_t    free_runs_{ };
+
         size_t active_count_{ };
         size_t highest_untouched_{ };
-    };
 
-    // Delete each element inside the block then the block
-    struct BlockDeleter
-    {
-        BlockAllocator block_alloc_;
+        // position in the chain, increases from first_block_ to last_block_
+        size_t serial_{ };
 
-        explicit BlockDeleter(const BlockAllocator& balloc_ = BlockAllocator()) noexcept
-            : block_alloc_(balloc_)
-        { }
+        // generational hives only: per slot generations, bumped on erase, and the
+        // block's index in the handle table
+        Skipfield* generations_{ nullptr };
+        Skipfield  max_generation_{ };
+        size_t     table_index_{ };
 
-        void operator()(Block* block)
-        {
-            if (block == nullptr) return;
-            ElementAllocator element_alloc_(block_alloc_);
-            ElementAllocTraits::deallocate(element_alloc_, block->elements_, block->capacity_);
+        [[nodiscard]] FreeLinks& links(size_t idx) noexcept { return elements_[idx].free_; }
+        void set_links(size_t idx, FreeLinks links) noexcept { elements_[idx].free_ = links; }
+    };
 
-            BlockAllocTraits::destroy(block_alloc_, block);
-            BlockAllocTraits::deallocate(block_alloc_, block,1);
-        }
+    // A block is a single allocation laid out as [Block | elements | skipfield | generations],
+    // counted in units aligned for both the header and the elements
+    static constexpr size_t BLOCK_ALIGN{ std::max(alignof(Block), alignof(Element)) };
+    struct alignas(BLOCK_ALIGN) BlockUnit
+    {
+        std::byte bytes[BLOCK_ALIGN];
     };
 
+    static constexpr size_t ELEMENTS_OFFSET{ (sizeof(Block) + alignof(Element) - 1) / alignof(Element) * alignof(Element) };
+    static constexpr size_t SKIPFIELDS_PER_SLOT{ Generational ? 2 : 1 };
+
     /* --- Base Iterator Class --- */
 public:
 
@@ -82,8 +319,12 @@ public:
     class base_iterator
     {
     public:
-        using pointer   = std::conditional_t<Const, const T*, T*>;
-        using reference = std::conditional_t<Const, const T&, T&>;
+        using iterator_concept  = std::bidirectional_iterator_tag;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
 
         base_iterator() = default;
         operator base_iterator<true>() const
@@ -105,30 +346,38 @@ public:
         // Not sure why (maybe due to const template resolution?)
         base_iterator& operator++()
         {
-            if (this->current_block_ == nullptr) 
+            if (this->current_block_ == nullptr)
                 return *this;
 
             ++this->idx_in_block_;
+            skip_to_active();
+            return *this;
+        }
 
-            while (this->current_block_ != nullptr)
-            {
-                while (this->idx_in_block_ < this->current_block_->highest_untouched_)
-                {
-                    if (this->current_block_->elements_[idx_in_block_].skip == 0)
-                        return *this;
+        base_iterator operator++(int)
+        {
+            base_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
 
-                    this->idx_in_block_ += this->current_block_->elements_[idx_in_block_].skip;
-                }
-                this->current_block_ = this->current_block_->next.get();
-                this->idx_in_block_ = 0;
+        base_iterator& operator--()
+        {
+            if (this->current_block_ == nullptr)
+                return *this;
+
+            while (!this->retreat_in_block() && this->current_block_->prev != nullptr)
+            {
+                this->current_block_ = this->current_block_->prev;
+                this->idx_in_block_ = this->current_block_->highest_untouched_;
             }
             return *this;
         }
 
-        base_iterator operator++(int)
+        base_iterator operator--(int)
         {
             base_iterator temp = *this;
-            ++(*this);
+            --(*this);
             return temp;
         }
 
@@ -136,7 +385,49 @@ public:
         {
             return current_block_ == other.current_block_ && idx_in_block_ == other.idx_in_block_;
         }
-    
+
+        // Found through ADL, these cross whole blocks using their active counts
+        // instead of visiting every element in between
+        template<std::integral Distance>
+        friend void advance(base_iterator& itr, Distance n)
+        {
+            if (n > 0)
+                itr.advance_forward(static_cast<difference_type>(n));
+            else if (n < 0)
+                itr.advance_backward(-static_cast<difference_type>(n));
+        }
+
+        friend base_iterator next(base_iterator itr, difference_type n = 1)
+        {
+            advance(itr, n);
+            return itr;
+        }
+
+        friend base_iterator prev(base_iterator itr, difference_type n = 1)
+        {
+            advance(itr, -n);
+            return itr;
+        }
+
+        // last may come before first, the result is then negative
+        friend difference_type distance(base_iterator first, base_iterator last)
+        {
+            if (first == last)
+                return 0;
+            if (last.precedes(first))
+                return -distance(last, first);
+
+            if (first.current_block_ == last.current_block_)
+                return static_cast<difference_type>(first.count_to(last.idx_in_block_));
+
+            size_t count{ first.count_to(first.current_block_->highest_untouched_) };
+            for (BlockPtr block = first.current_block_->next.get(); block != last.current_block_; block = block->next.get())
+                count += block->active_count_;
+
+            const base_iterator last_block_start(last.current_block_, 0);
+            return static_cast<difference_type>(count + last_block_start.count_to(last.idx_in_block_));
+        }
+
     private:
         friend class hive;
         using BlockPtr = std::conditional_t<Const, const Block*, Block*>;
@@ -147,298 +438,2046 @@ public:
             : current_block_(block),
               idx_in_block_(idx)
         { }
-    };
-
-    using iterator       = base_iterator<false>;
-    using const_iterator = base_iterator<true>;
 
+        // Moves to the first active element at or after the current position, or to
+        // the end of the last block. An erased run is crossed in one jump since its
+        // first slot holds its length.
+        void skip_to_active()
+        {
+            while (this->current_block_ != nullptr)
+            {
+                if (this->idx_in_block_ < this->current_block_->highest_untouched_)
+                {
+                    this->idx_in_block_ += this->current_block_->skipfield_[this->idx_in_block_];
+                    if (this->idx_in_block_ < this->current_block_->highest_untouched_)
+                        return;
+                }
+                if (this->current_block_->next == nullptr)
+                {
+                    this->idx_in_block_ = this->current_block_->highest_untouched_;
+                    return;
+                }
+                this->current_block_ = this->current_block_->next.get();
+                this->idx_in_block_ = 0;
+            }
+        }
 
-    /* --- Member Variables --- */
-private:
-    using BlockPtr = std::unique_ptr<Block, BlockDeleter>;
-    BlockPtr first_block_;
-    Block*   last_block_{ nullptr };
+        // Moves to the previous active element of this block, the last slot of an
+        // erased run holds its length too. Returns false if there is none.
+        bool retreat_in_block()
+        {
+            if (this->idx_in_block_ == 0)
+                return false;
 
-    Element*  free_list_head_{ nullptr };
-    Allocator allocator_{ };
+            const size_t pos{ this->idx_in_block_ - 1 };
+            const size_t gap{ this->current_block_->skipfield_[pos] };
+            if (pos < gap)
+                return false;
 
-    size_t size_{ };
-    size_t capacity_{ };
-    static constexpr size_t INITIAL_CAPACITY{ 4 };
-    size_t next_block_capacity_{ INITIAL_CAPACITY };
+            this->idx_in_block_ = pos - gap;
+            return true;
+        }
 
+        // Moves up to n elements forward inside the current block, crossing whole active
+        // runs at once, and returns how many are left. Stepping off the last element
+        // counts as one and leaves the iterator at highest_untouched_.
+        difference_type advance_in_block(difference_type n)
+        {
+            const Skipfield* skip{ this->current_block_->skipfield_ };
+            const size_t last{ this->current_block_->highest_untouched_ };
+            while (n > 0 && this->idx_in_block_ < last)
+            {
+                const size_t run_last{ hive_detail::find_nonzero(skip, this->idx_in_block_ + 1, last) };
+                const auto ahead{ static_cast<difference_type>(run_last - this->idx_in_block_) };
+                if (n < ahead)
+                {
+                    this->idx_in_block_ += static_cast<size_t>(n);
+                    return 0;
+                }
+                n -= ahead;
+                this->idx_in_block_ = run_last;
+                if (run_last < last)
+                    this->idx_in_block_ += skip[run_last];
+            }
+            return n;
+        }
 
-    /* --- Hive Special Member Functions --- */
-public:
-    explicit hive(const Allocator& alloc = Allocator())
-        : allocator_(alloc)
-    { }
+        void advance_forward(difference_type n)
+        {
+            n = advance_in_block(n);
+            if (this->idx_in_block_ < this->current_block_->highest_untouched_)
+                return;
+
+            // past the last element of a block is the first element of the next one,
+            // blocks with no more than n elements are crossed whole
+            while (this->current_block_->next != nullptr &&
+                   static_cast<size_t>(n) >= this->current_block_->next->active_count_)
+            {
+                this->current_block_ = this->current_block_->next.get();
+                n -= static_cast<difference_type>(this->current_block_->active_count_);
+            }
 
-    ~hive() { clear(); }
+            if (this->current_block_->next == nullptr)
+            {
+                this->idx_in_block_ = this->current_block_->highest_untouched_;
+                return;
+            }
 
-    void clear() noexcept
-    {
-        if (first_block_ == nullptr) return;
+            this->current_block_ = this->current_block_->next.get();
+            this->idx_in_block_ = 0;
+            this->skip_to_active();
+            advance_in_block(n);
+        }
 
-        Block* curr_block = first_block_.get();
-        while (curr_block != nullptr)
+        void advance_backward(difference_type n)
         {
-            for (size_t i{}; i<curr_block->highest_untouched_; ++i)
+            while (n > 0 && this->retreat_in_block())
+                --n;
+            if (n == 0)
+                return;
+
+            // at the first element of a block, earlier blocks with fewer than n elements are crossed whole
+            while (this->current_block_->prev != nullptr &&
+                   static_cast<size_t>(n) > this->current_block_->prev->active_count_)
             {
-                if (curr_block->elements_[i].skip == 0)
-                    AllocTraits::destroy(allocator_, &curr_block->elements_[i].data);
+                this->current_block_ = this->current_block_->prev;
+                n -= static_cast<difference_type>(this->current_block_->active_count_);
             }
 
-            curr_block = curr_block->next.get();
+            if (this->current_block_->prev == nullptr)
+                return;
+
+            this->current_block_ = this->current_block_->prev;
+            this->idx_in_block_ = this->current_block_->highest_untouched_;
+            for (; n > 0; --n)
+                this->retreat_in_block();
         }
 
-        first_block_.reset(); // next pointer is unique so recursive destruct? (i hope)
-        last_block_ = nullptr;
-        free_list_head_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
-    }
+        // Active elements in [idx_in_block_, stop) of the current block
+        [[nodiscard]] size_t count_to(size_t stop) const
+        {
+            return hive_detail::count_active(this->current_block_->skipfield_, idx_in_block_, stop);
+        }
 
-    void swap(hive& other) noexcept
-    {
-        using std::swap;
+        [[nodiscard]] bool precedes(const base_iterator& other) const
+        {
+            if (current_block_ == other.current_block_)
+                return idx_in_block_ < other.idx_in_block_;
+            return current_block_->serial_ < other.current_block_->serial_;
+        }
+    };
 
-        swap(first_block_, other.first_block_);
-        swap(last_block_ , other.last_block_);
+    using iterator               = base_iterator<false>;
+    using const_iterator         = base_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /* --- Handles --- */
+    // Generational hives only. A handle packs [block index | generation | slot] into one
+    // word. Erasing an element bumps its slot's generation, so get() returns nullptr for
+    // handles to erased elements even after the slot is reused. Generations are compared
+    // modulo 2^GENERATION_BITS, a handle held across that many erasures of its slot can
+    // match again.
+    template<std::unsigned_integral Word>
+    class basic_handle
+    {
+    public:
+        static constexpr int SLOT_BITS{ std::numeric_limits<Skipfield>::digits };
+        static constexpr int GENERATION_BITS{ std::min((std::numeric_limits<Word>::digits - SLOT_BITS) / 2,
+                                                       std::numeric_limits<Skipfield>::digits) };
+        static constexpr int BLOCK_BITS{ std::numeric_limits<Word>::digits - SLOT_BITS - GENERATION_BITS };
+        static_assert(GENERATION_BITS > 0 && BLOCK_BITS > 0, "Handle word too narrow for this skipfield.");
 
-        swap(free_list_head_, other.free_list_head_);
-        swap(allocator_, other.allocator_);
+        // the all ones block index is reserved for the null handle
+        static constexpr size_t MAX_BLOCKS{ (size_t{ 1 } << BLOCK_BITS) - 1 };
 
-        swap(size_, other.size_);
-        swap(capacity_, other.capacity_);
-    }
+        basic_handle() = default;
 
-    [[nodiscard]] bool is_empty() const noexcept { return size_ == 0; }
-    [[nodiscard]] size_t size() const noexcept { return size_; }
-    [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+        [[nodiscard]] Word   value() const { return value_; }
+        [[nodiscard]] size_t block() const { return static_cast<size_t>(value_ >> (SLOT_BITS + GENERATION_BITS)); }
+        [[nodiscard]] size_t slot() const { return static_cast<size_t>(value_ & mask(SLOT_BITS)); }
+        [[nodiscard]] Word   generation() const { return (value_ >> SLOT_BITS) & mask(GENERATION_BITS); }
+        [[nodiscard]] bool   is_null() const { return value_ == std::numeric_limits<Word>::max(); }
 
-    [[nodiscard]] iterator begin() noexcept;
-    [[nodiscard]] const_iterator begin() const noexcept;
+        bool operator==(const basic_handle&) const = default;
 
-    [[nodiscard]] iterator end() noexcept { return iterator(nullptr, 0); }
-    [[nodiscard]] const_iterator end() const noexcept { return const_iterator(nullptr, 0); }
+    private:
+        friend class hive;
 
-    iterator insert(const T& obj);
-    iterator insert(T&& obj);
-    
-    template<typename... Args>
-    iterator emplace(Args&&... args);
+        basic_handle(size_t block, Skipfield generation, size_t slot)
+            : value_(static_cast<Word>((Word(block) << (SLOT_BITS + GENERATION_BITS))
+                                       | ((Word(generation) & mask(GENERATION_BITS)) << SLOT_BITS)
+                                       | Word(slot)))
+        { }
 
-    iterator erase(iterator itr);
+        static constexpr Word mask(int bits) { return static_cast<Word>((Word{ 1 } << bits) - 1); }
 
-private:
-    void add_block();
-    void update_skipfield_on_emplace(Block* block, size_t idx);
-    void update_skipfield_on_erase(Block* block, size_t idx);
-};
+        Word value_{ std::numeric_limits<Word>::max() };
+    };
 
-    /* --- Forward Declared Functions --- */
+    using handle         = basic_handle<std::uint64_t>;
+    using compact_handle = basic_handle<std::uint32_t>;
 
-template<typename T, typename Allocator>
-void hive<T, Allocator>::add_block()
-{
-    BlockAllocator block_alloc{ allocator_ };
-    ElementAllocator elem_alloc{ allocator_ };
 
-    Block* raw_block{ BlockAllocTraits::allocate(block_alloc, 1) };
-    BlockAllocTraits::construct(block_alloc, raw_block);
+    /* --- Segments --- */
+    // A segment is one run of consecutive active elements in a block. When an Element is
+    // exactly a T, a segment is a std::span over the elements, otherwise the free list
+    // links make the union wider than T and a segment is a strided view projecting .data
+    static constexpr bool CONTIGUOUS_SEGMENTS{ sizeof(Element) == sizeof(T) };
 
+    // Finding where a run ends costs about as much as visiting 16 elements one by one, so
+    // in blocks whose runs average fewer active elements than this every element is its
+    // own segment, found the way iterators find it. Segments stay maximal runs elsewhere.
+    static constexpr size_t MIN_SEGMENT_RUN{ 16 };
 
-    BlockPtr new_block{ raw_block, BlockDeleter{ block_alloc }};
-    new_block->capacity_ = next_block_capacity_;
-    new_block->elements_ = ElementAllocTraits::allocate(elem_alloc, next_block_capacity_);
+private:
+    template<bool Const>
+    struct ElementData
+    {
+        using Ref = std::conditional_t<Const, const T&, T&>;
+        Ref operator()(std::conditional_t<Const, const Element&, Element&> elem) const noexcept { return elem.data; }
+    };
 
-    for (size_t i{}; i < new_block->capacity_; ++i)
-        ElementAllocTraits::construct(elem_alloc, &new_block->elements_[i]);
+    template<bool Const>
+    using strided_segment = std::ranges::transform_view<std::span<std::conditional_t<Const, const Element, Element>>,
+                                                        ElementData<Const>>;
 
-    this->capacity_ += next_block_capacity_;
+public:
+    template<bool Const>
+    using basic_segment = std::conditional_t<CONTIGUOUS_SEGMENTS,
+                                             std::span<std::conditional_t<Const, const T, T>>,
+                                             strided_segment<Const>>;
+    using segment       = basic_segment<false>;
+    using const_segment = basic_segment<true>;
 
-    if (last_block_ == nullptr) [[unlikely]]
-    {
-        first_block_ = std::move(new_block);
-        last_block_ = first_block_.get();
-    }
-    else
+    // Forward range over the segments of a hive, in iteration order
+    template<bool Const>
+    class segment_view
     {
-        new_block->prev = last_block_;
-        last_block_->next = std::move(new_block);
-        last_block_ = last_block_->next.get();
-    }
+    public:
+        class iterator
+        {
+        public:
+            using iterator_concept = std::forward_iterator_tag;
+            using value_type       = basic_segment<Const>;
+            using difference_type  = std::ptrdiff_t;
 
-    for (size_t i{}; i<next_block_capacity_; ++i)
-        last_block_->elements_[i].parent = last_block_;
+            iterator() = default;
 
-    last_block_->elements_[0].skip = last_block_->capacity_;
-    last_block_->elements_[next_block_capacity_-1].skip = last_block_->capacity_;
+            [[nodiscard]] value_type operator*() const
+            {
+                using ElementT = std::conditional_t<Const, const Element, Element>;
+                ElementT* first{ block_->elements_ + first_ };
+                if constexpr (CONTIGUOUS_SEGMENTS)
+                    return value_type{ &first->data, last_ - first_ };
+                else
+                    return value_type{ std::span<ElementT>{ first, last_ - first_ }, ElementData<Const>{ } };
+            }
 
-    next_block_capacity_ *= 2;
-}
+            iterator& operator++()
+            {
+                first_ = last_;
+                find_run();
+                return *this;
+            }
 
-template<typename T, typename Allocator>
-typename hive<T, Allocator>::iterator 
-hive<T,Allocator>::begin() noexcept
-{    
-    if (last_block_ == nullptr || is_empty()) 
-        return end();
+            iterator operator++(int)
+            {
+                iterator temp{ *this };
+                ++*this;
+                return temp;
+            }
 
-    Block* curr_block = first_block_.get();
+            [[nodiscard]] bool operator==(const iterator& other) const = default;
+            [[nodiscard]] bool operator==(std::default_sentinel_t) const { return block_ == nullptr; }
 
-    while (curr_block != nullptr)
-    {
-        for (size_t idx{}; idx<curr_block->highest_untouched_; ++idx)
-        {
-            if (curr_block->elements_[idx].skip == 0)
-                return iterator(curr_block, idx);
-        }
-        curr_block = curr_block->next.get();
-    }
+        private:
+            friend class segment_view;
 
-    return end();
-}
+            explicit iterator(Block* block)
+                : block_(block)
+            { find_run(); }
 
-template<typename T, typename Allocator>
-typename hive<T, Allocator>::const_iterator
-hive<T,Allocator>::begin() const noexcept
-{    
-    if (last_block_ == nullptr || is_empty()) 
-        return end();
+            // moves first_ to the next active slot, across blocks, and finds where its run ends
+            void find_run()
+            {
+                while (block_ != nullptr)
+                {
+                    const size_t last{ block_->highest_untouched_ };
+                    if (first_ < last)
+                        first_ += block_->skipfield_[first_];
+                    if (first_ < last)
+                    {
+                        last_ = block_->active_count_ < MIN_SEGMENT_RUN * block_->free_runs_
+                              ? first_ + 1
+                              : hive_detail::find_nonzero(block_->skipfield_, first_ + 1, last);
+                        return;
+                    }
+                    block_ = block_->next.get();
+                    first_ = 0;
+                }
+                last_ = 0;
+            }
 
-    Block* curr_block = first_block_.get();
+            Block* block_{ nullptr };
+            size_t first_{ };
+            size_t last_{ };
+        };
 
-    while (curr_block != nullptr)
-    {
-        for (size_t idx{}; idx<curr_block->highest_untouched_; ++idx)
-        {
-            if (curr_block->elements_[idx].skip == 0)
-                return const_iterator(curr_block, idx);
-        }
-        curr_block = curr_block->next.get();
-    }
+        [[nodiscard]] iterator begin() const { return iterator{ first_block_ }; }
+        [[nodiscard]] std::default_sentinel_t end() const { return { }; }
 
-    return end();
-}
+    private:
+        friend class hive;
 
-template<typename T, typename Allocator>
-typename hive<T, Allocator>::iterator 
-hive<T, Allocator>::insert(const T& obj)
-{
-    return emplace(obj);
-}
+        explicit segment_view(Block* first_block)
+            : first_block_(first_block)
+        { }
 
-template<typename T, typename Allocator>
-typename hive<T, Allocator>::iterator 
-hive<T, Allocator>::insert(T&& obj)
-{
-    return emplace(std::move(obj));
-}
+        Block* first_block_{ nullptr };
+    };
 
-template<typename T, typename Allocator>
-template<typename... Args>
-typename hive<T, Allocator>::iterator 
-hive<T, Allocator>::emplace(Args&&... args)
-{
-    Block* free_parent{ nullptr };
-    Element* free_element{ nullptr };
+
+    /* --- Member Variables --- */
+private:
+    using BlockPtr = std::unique_ptr<Block, BlockDeleter>;
+    BlockPtr first_block_;
+    Block*   last_block_{ nullptr };
+
+    FreeBlocks free_blocks_;
+    Allocator  allocator_{ };
+
+    // first active element, kept up to date so begin() is O(1), null when empty
+    Block* begin_block_{ nullptr };
+    size_t begin_idx_{ };
+
+    size_t size_{ };
+    size_t capacity_{ };
+    static constexpr size_t INITIAL_CAPACITY{ 4 };
+    size_t next_block_capacity_{ INITIAL_CAPACITY };
+
+    // every new block is sized within block_limits_, growing by growth_factor_
+    hive_limits block_limits_{ INITIAL_CAPACITY, MAX_BLOCK_CAPACITY };
+    double growth_factor_{ 2.0 };
+
+    // blocks emptied by erase are unlinked from the chain, up to spare_block_limit_
+    // of them are kept here for add_block to reuse, the rest are freed
+    static constexpr size_t DEFAULT_SPARE_BLOCK_LIMIT{ 1 };
+    BlockPtr spare_blocks_;
+    size_t spare_block_count_{ };
+    size_t spare_block_limit_{ DEFAULT_SPARE_BLOCK_LIMIT };
+
+    // Maps handle block indices to blocks. A freed index keeps a generation floor above
+    // every generation its old block handed out, so stale handles never match the next
+    // block there.
+    struct BlockTable
+    {
+        std::vector<Block*>    blocks_;
+        std::vector<Skipfield> floors_;
+        std::vector<size_t>    free_indices_;
+    };
+    struct NoBlockTable { };
+    [[no_unique_address]] std::conditional_t<Generational, BlockTable, NoBlockTable> table_;
+
+    struct NoCounters { };
+    [[no_unique_address]] std::conditional_t<hive_counters_enabled, hive_counters, NoCounters> counters_;
+
+    // Embedded first block of small hives, used by add_block whenever it is free. It never
+    // changes owner, so moving a hive that uses it moves the elements instead.
+    static_assert(InlineCapacity <= MAX_BLOCK_CAPACITY, "Inline capacity exceeds the skipfield's block capacity.");
+    static constexpr size_t INLINE_BYTES{ (ELEMENTS_OFFSET + InlineCapacity * (sizeof(Element) + SKIPFIELDS_PER_SLOT * sizeof(Skipfield))
+                                           + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN };
+    struct InlineBlock
+    {
+        alignas(BLOCK_ALIGN) std::byte bytes_[INLINE_BYTES];
+        bool in_use_{ false };
+    };
+    struct NoInlineBlock { };
+    [[no_unique_address]] std::conditional_t<(InlineCapacity > 0), InlineBlock, NoInlineBlock> inline_;
+
+    [[nodiscard]] bool is_inline(const Block* block) const noexcept
+    {
+        if constexpr (InlineCapacity > 0)
+            return static_cast<const void*>(block) == static_cast<const void*>(inline_.bytes_);
+        else
+            return false;
+    }
+
+    [[nodiscard]] bool inline_in_use() const noexcept
+    {
+        if constexpr (InlineCapacity > 0)
+            return inline_.in_use_;
+        else
+            return false;
+    }
+
+    void count_event([[maybe_unused]] size_t hive_counters::* counter, [[maybe_unused]] size_t n = 1) noexcept
+    {
+        if constexpr (hive_counters_enabled)
+            counters_.*counter += n;
+    }
+
+
+    /* --- Hive Special Member Functions --- */
+public:
+    explicit hive(const Allocator& alloc = Allocator())
+        : allocator_(alloc)
+    { }
+
+    explicit hive(hive_limits block_limits, const Allocator& alloc = Allocator())
+        : allocator_(alloc),
+          next_block_capacity_(block_limits.min),
+          block_limits_(block_limits)
+    {
+        check_block_capacity_limits(block_limits);
+    }
+
+    // Copies pack the active elements into as few blocks as the limits allow, so copying
+    // a fragmented hive also defragments it
+    hive(const hive& other)
+        : hive(other, AllocTraits::select_on_container_copy_construction(other.allocator_))
+    { }
+    hive(const hive& other, const Allocator& alloc);
+
+    hive& operator=(const hive& other)
+    {
+        if (this != &other)
+            hive_detail::copy_assign(*this, allocator_, other, other.allocator_);
+
+        return *this;
+    }
+
+    // Moves steal the block chain, other is left empty with default settings.
+    // An embedded block in use cannot be stolen, its hive's elements are moved one by one.
+    hive(hive&& other) noexcept(InlineCapacity == 0)
+        : allocator_(other.allocator_)
+    {
+        if (other.inline_in_use())
+            move_elements_from(other);
+        else
+            swap_chains(other);
+    }
+
+    // Steals other's blocks unless this hive's allocator cannot free them or other's
+    // embedded block is in use, then the elements are moved one by one
+    hive& operator=(hive&& other) noexcept(InlineCapacity == 0 && hive_detail::always_steals_blocks<Allocator>)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        hive_detail::move_assign(allocator_, other.allocator_, !other.inline_in_use(),
+                                 [&] { swap_chains(other); },
+                                 [&] { move_elements_from(other); });
+
+        return *this;
+    }
+
+    ~hive() { clear(); }
+
+    void clear() noexcept
+    {
+        if (first_block_ == nullptr && spare_blocks_ == nullptr) return;
+
+        destroy_elements();
+        free_chain(first_block_);
+        free_chain(spare_blocks_);
+        reset_chain();
+    }
+
+    [[nodiscard]] Allocator get_allocator() const noexcept { return allocator_; }
+
+    // Forgets every block without destroying or freeing anything when T is trivially
+    // destructible, O(1) then, otherwise elements are destroyed first. Only for
+    // polymorphic allocators, whose resource (e.g. std::pmr::monotonic_buffer_resource)
+    // releases the blocks in bulk; with any other allocator the blocks would leak.
+    void drop() noexcept
+        requires std::same_as<Allocator, std::pmr::polymorphic_allocator<T>>;
+
+    // Allocators follow hive_detail::swap_allocators
+    void swap(hive& other) noexcept(InlineCapacity == 0)
+    {
+        if (inline_in_use() || other.inline_in_use())
+        {
+            hive temp{ std::move(other) };
+            other = std::move(*this);
+            *this = std::move(temp);
+            return;
+        }
+        swap_chains(other);
+    }
+
+private:
+    // Exchanges everything but the embedded blocks, which must both be unused
+    void swap_chains(hive& other) noexcept
+    {
+        using std::swap;
+
+        swap(first_block_, other.first_block_);
+        swap(last_block_ , other.last_block_);
+
+        free_blocks_.swap(other.free_blocks_);
+        hive_detail::swap_allocators(allocator_, other.allocator_);
+
+        swap(begin_block_, other.begin_block_);
+        swap(begin_idx_, other.begin_idx_);
+
+        swap(size_, other.size_);
+        swap(capacity_, other.capacity_);
+        swap(next_block_capacity_, other.next_block_capacity_);
+        swap(block_limits_, other.block_limits_);
+        swap(growth_factor_, other.growth_factor_);
+
+        swap(spare_blocks_, other.spare_blocks_);
+        swap(spare_block_count_, other.spare_block_count_);
+        swap(spare_block_limit_, other.spare_block_limit_);
+        swap(table_, other.table_);
+        swap(counters_, other.counters_);
+    }
+
+    void move_elements_from(hive& other)
+    {
+        block_limits_ = other.block_limits_;
+        growth_factor_ = other.growth_factor_;
+        spare_block_limit_ = other.spare_block_limit_;
+        next_block_capacity_ = block_limits_.min;
+        insert(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        other.clear();
+    }
+
+public:
+
+    [[nodiscard]] bool is_empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+    // Walks every block, O(blocks + erased runs)
+    [[nodiscard]] hive_stats stats() const;
+
+    // All zero unless built with HIVE_COUNTERS
+    [[nodiscard]] hive_counters counters() const noexcept
+    {
+        if constexpr (hive_counters_enabled)
+            return counters_;
+        else
+            return hive_counters{ };
+    }
+
+    // Number of emptied blocks kept for reuse instead of being freed
+    [[nodiscard]] size_t spare_block_limit() const noexcept { return spare_block_limit_; }
+    void set_spare_block_limit(size_t limit) noexcept;
+
+    // Frees spare blocks, keeping enough of them for capacity() to stay >= min_capacity
+    void trim_capacity(size_t min_capacity = 0) noexcept;
+    void shrink_to_fit() noexcept { trim_capacity(); }
+
+    // Allocates blocks up front so capacity() >= new_capacity, they are used before any new allocation
+    void reserve(size_t new_capacity);
+
+    [[nodiscard]] static constexpr hive_limits block_capacity_hard_limits() noexcept
+    {
+        return hive_limits{ 1, MAX_BLOCK_CAPACITY };
+    }
+    [[nodiscard]] hive_limits block_capacity_limits() const noexcept { return block_limits_; }
+    void set_block_capacity_limits(hive_limits limits);
+
+    // Each new block is growth_factor() times the previous one, clamped to the limits
+    [[nodiscard]] double growth_factor() const noexcept { return growth_factor_; }
+    void set_growth_factor(double factor);
+
+    // Largest block capacity whose whole allocation (header, slots, skipfield and, for
+    // generational hives, generations) fits in the given number of bytes, useful for
+    // sizing blocks to cache lines or pages. At least 1, which may not fit tiny budgets.
+    [[nodiscard]] static constexpr size_t block_capacity_for_bytes(size_t bytes) noexcept
+    {
+        // blocks are allocated in whole BLOCK_ALIGN units, as block_units() counts them
+        const size_t usable{ bytes / BLOCK_ALIGN * BLOCK_ALIGN };
+        if (usable <= ELEMENTS_OFFSET)
+            return 1;
+        const size_t fitted{ (usable - ELEMENTS_OFFSET) / (sizeof(Element) + SKIPFIELDS_PER_SLOT * sizeof(Skipfield)) };
+        return std::clamp<size_t>(fitted, 1, MAX_BLOCK_CAPACITY);
+    }
+
+    [[nodiscard]] iterator begin() noexcept;
+    [[nodiscard]] const_iterator begin() const noexcept;
+
+    // end is one past the last slot in use of the last block
+    [[nodiscard]] iterator end() noexcept
+    {
+        return last_block_ != nullptr ? iterator(last_block_, last_block_->highest_untouched_) : iterator(nullptr, 0);
+    }
+    [[nodiscard]] const_iterator end() const noexcept
+    {
+        return last_block_ != nullptr ? const_iterator(last_block_, last_block_->highest_untouched_) : const_iterator(nullptr, 0);
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+
+    [[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+
+    [[nodiscard]] const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    [[nodiscard]] const_reverse_iterator crend() const noexcept { return rend(); }
+
+    // Runs of active elements as contiguous segments, inner loops over a segment need no
+    // skipfield checks and can be vectorized. Blocks fragmented past MIN_SEGMENT_RUN yield
+    // single elements, as cheap as iterating them but no cheaper.
+    [[nodiscard]] segment_view<false> segments() noexcept { return segment_view<false>{ first_block_.get() }; }
+    [[nodiscard]] segment_view<true> segments() const noexcept { return segment_view<true>{ first_block_.get() }; }
+
+    template<typename Func>
+    void for_each_segment(Func func)
+    {
+        for (segment seg : segments())
+            func(seg);
+    }
+    template<typename Func>
+    void for_each_segment(Func func) const
+    {
+        for (const_segment seg : segments())
+            func(seg);
+    }
+
+    iterator insert(const T& obj);
+    iterator insert(T&& obj);
+
+    // Bulk insertion fills erased runs and fresh blocks a run at a time,
+    // constructing each run contiguously with one skipfield update
+    template<std::input_iterator It, std::sentinel_for<It> Sent>
+    void insert(It first, Sent last);
+    void insert(size_t count, const T& obj);
+    void insert(std::initializer_list<T> list) { insert(list.begin(), list.end()); }
+
+    template<std::ranges::input_range Range>
+    void insert_range(Range&& range) { insert(std::ranges::begin(range), std::ranges::end(range)); }
+
+    template<typename... Args>
+    iterator emplace(Args&&... args);
+
+    iterator erase(iterator itr);
+
+    // Erases [first, last) a run at a time, returns last
+    iterator erase(const_iterator first, const_iterator last);
+
+    // Moves every block of other to the end of this hive without touching elements, so
+    // pointers and iterators to them stay valid. other keeps its spare blocks.
+    // Throws std::length_error if a block is outside this hive's capacity limits.
+    // Not available for small hives, an embedded block cannot move to another hive.
+    void splice(hive& other) requires (InlineCapacity == 0);
+    void splice(hive&& other) requires (InlineCapacity == 0) { splice(other); }
+
+    // Moves elements from the last block into erased slots of earlier blocks and frees the
+    // blocks this empties. relocate(old, new) is called after each move while both objects
+    // are alive, so external pointers can be fixed up, and must not throw. If a move
+    // throws, the elements moved so far stay moved and the rest stay where they were.
+    template<typename Relocate = no_relocate>
+    void compact(Relocate relocate = Relocate());
+
+    // Incremental compact(), moves at most max_moves elements per call and returns true
+    // once there is nothing left to compact
+    template<typename Relocate = no_relocate>
+    bool compact_step(size_t max_moves, Relocate relocate = Relocate());
+
+    // Sorts the values and writes them back through the existing slots. No block is
+    // allocated or freed, iterators stay valid but may then refer to different values.
+    // Values up to 256 bytes that move without throwing are sorted in a contiguous buffer,
+    // at about the cost of sorting a vector. Larger ones are sorted as slot pointers and
+    // permuted in place, each moved about once: about 3x faster at 512 bytes, 1.5x
+    // slower than the buffer at 100 bytes.
+    template<typename Compare = std::less<>>
+    void sort(Compare comp = Compare());
+
+    // Erases every element equal to the one before it, returns the number erased
+    template<typename BinaryPredicate = std::equal_to<>>
+    size_t unique(BinaryPredicate pred = BinaryPredicate());
+
+    // Generational hives only. get() returns nullptr once the element is erased.
+    // Throws std::length_error if the hive has more blocks than Word can index.
+    template<std::unsigned_integral Word = std::uint64_t>
+    [[nodiscard]] basic_handle<Word> get_handle(const_iterator itr) const requires Generational;
+
+    template<std::unsigned_integral Word>
+    [[nodiscard]] T* get(basic_handle<Word> h) requires Generational
+    { return const_cast<T*>(std::as_const(*this).get(h)); }
+    template<std::unsigned_integral Word>
+    [[nodiscard]] const T* get(basic_handle<Word> h) const requires Generational;
+
+    /* --- Parallel Traversal --- */
+    // The block chain is cut into contiguous chunks with balanced active counts and the
+    // chunks run on the pool's workers and the calling thread. max_threads == 0 uses every
+    // worker of the pool. The callable must be safe to invoke concurrently on different elements.
+    template<typename Func>
+    void parallel_for_each(Func func, size_t max_threads = 0, hive_thread_pool& pool = hive_thread_pool::shared());
+    template<typename Func>
+    void parallel_for_each(Func func, size_t max_threads = 0, hive_thread_pool& pool = hive_thread_pool::shared()) const;
+
+    // Replaces every element with func(element)
+    template<typename Func>
+    void parallel_transform(Func func, size_t max_threads = 0, hive_thread_pool& pool = hive_thread_pool::shared());
+
+    // Combines map(element) of every element with init using reduce, which must be associative
+    template<typename R, typename Reduce, typename Map>
+    [[nodiscard]] R parallel_transform_reduce(R init, Reduce reduce, Map map, size_t max_threads = 0,
+                                              hive_thread_pool& pool = hive_thread_pool::shared()) const;
+    template<typename R, typename Reduce = std::plus<>>
+    [[nodiscard]] R parallel_reduce(R init, Reduce reduce = Reduce(), size_t max_threads = 0,
+                                    hive_thread_pool& pool = hive_thread_pool::shared()) const;
+
+private:
+    // below this many elements per thread the traversal stays on the calling thread
+    static constexpr size_t MIN_PARALLEL_CHUNK{ 4096 };
+
+    std::vector<Block*> partition_blocks(size_t max_threads, const hive_thread_pool& pool) const;
+    template<typename ChunkFunc>
+    static void run_chunks(const std::vector<Block*>& chunk_starts, ChunkFunc& run_chunk, hive_thread_pool& pool);
+    template<typename Func>
+    static void visit_block(Block* block, Func& func);
+
+    void add_block();
+    // next block capacity after one of capacity slots, within block_limits_
+    [[nodiscard]] size_t grown_capacity(size_t capacity) const noexcept;
+    BlockPtr allocate_block(size_t block_capacity);
+    static Block* place_block(std::byte* bytes, size_t block_capacity) noexcept;
+    BlockPtr make_inline_block() requires (InlineCapacity > 0);
+    static void check_block_capacity_limits(hive_limits limits);
+    void update_begin_on_emplace(Block* block, size_t idx) noexcept;
+
+    template<typename Filler>
+    void insert_bulk(size_t count, Filler&& fill);
+
+    template<typename Pred>
+    size_t erase_where(Pred& pred);
+    template<typename Pred>
+    void erase_in_block(Block* block, size_t idx, size_t end_idx, Pred& pred);
+    void reset_begin() noexcept;
+
+    template<typename U, typename A, hive_skipfield S, bool G, size_t N, typename Pred>
+    friend size_t erase_if(hive<U, A, S, G, N>& h, Pred pred);
+
+    void release_block(Block* block) noexcept;
+    void free_chain(BlockPtr& chain) noexcept;
+    void destroy_elements() noexcept;
+    void reset_chain() noexcept;
+    void free_block(BlockPtr block) noexcept;
+    void free_spare_block() noexcept;
+
+    void register_block(Block* block);
+    void retire_table_index(const Block* block) noexcept;
+    void bump_generation(Block* block, size_t idx) noexcept;
+};
+
+    /* --- Forward Declared Functions --- */
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::hive(const hive& other, const Allocator& alloc)
+    : allocator_(alloc),
+      next_block_capacity_(other.block_limits_.min),
+      block_limits_(other.block_limits_),
+      growth_factor_(other.growth_factor_),
+      spare_block_limit_(other.spare_block_limit_)
+{
+    // source cursor, always on an active slot or the start of an erased run
+    const Block* src_block{ other.first_block_.get() };
+    size_t src_idx{ };
+
+    // insert_bulk sizes the first block for everything, up to block_limits_.max
+    const auto copy_runs = [this, &src_block, &src_idx](Element* slots, size_t run)
+    {
+        size_t copied{ };
+        try
+        {
+            while (copied < run)
+            {
+                const size_t src_last{ src_block->highest_untouched_ };
+                if (src_idx < src_last)
+                    src_idx += src_block->skipfield_[src_idx];
+                if (src_idx >= src_last)
+                {
+                    src_block = src_block->next.get();
+                    src_idx = 0;
+                    continue;
+                }
+
+                // copy the active run, or as much of it as fits in this destination run
+                const size_t run_last{ hive_detail::find_nonzero(src_block->skipfield_, src_idx + 1, src_last) };
+                const size_t count{ std::min(run_last - src_idx, run - copied) };
+                if constexpr (TRIVIAL_COPY && sizeof(Element) == sizeof(T))
+                {
+                    std::memcpy(static_cast<void*>(slots + copied), src_block->elements_ + src_idx, count * sizeof(T));
+                    copied += count;
+                    src_idx += count;
+                }
+                else
+                {
+                    for (const size_t stop{ src_idx + count }; src_idx<stop; ++src_idx, ++copied)
+                        AllocTraits::construct(allocator_, &slots[copied].data, src_block->elements_[src_idx].data);
+                }
+            }
+        }
+        catch (...)
+        {
+            for (size_t i{}; i<copied; ++i)
+                AllocTraits::destroy(allocator_, &slots[i].data);
+            throw;
+        }
+    };
+
+    try
+    {
+        insert_bulk(other.size_, copy_runs);
+    }
+    catch (...)
+    {
+        // the destructor does not run for a throwing constructor
+        clear();
+        throw;
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::add_block()
+{
+    if (spare_blocks_ != nullptr)
+    {
+        // spares are already counted in capacity_ and do not advance the growth
+        BlockPtr spare{ std::move(spare_blocks_) };
+        spare_blocks_ = std::move(spare->next);
+        --spare_block_count_;
+
+        hive_detail::append_block(first_block_, last_block_, std::move(spare));
+        count_event(&hive_counters::spare_block_reuses);
+        return;
+    }
+
+    if constexpr (InlineCapacity > 0)
+    {
+        // no allocation while the embedded block is free, heap blocks grow on from its size
+        if (!inline_.in_use_)
+        {
+            hive_detail::append_block(first_block_, last_block_, make_inline_block());
+            next_block_capacity_ = std::max(next_block_capacity_, grown_capacity(InlineCapacity));
+            return;
+        }
+    }
+
+    hive_detail::append_block(first_block_, last_block_, allocate_block(next_block_capacity_));
+
+    next_block_capacity_ = grown_capacity(next_block_capacity_);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+size_t hive<T, Allocator, Skipfield, Generational, InlineCapacity>::grown_capacity(size_t capacity) const noexcept
+{
+    // clamped as a double, converting a product past SIZE_MAX to size_t is undefined
+    const double grown{ std::min(static_cast<double>(capacity) * growth_factor_, static_cast<double>(block_limits_.max)) };
+    return std::clamp(static_cast<size_t>(grown), block_limits_.min, block_limits_.max);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+size_t hive<T, Allocator, Skipfield, Generational, InlineCapacity>::block_units(size_t capacity) noexcept
+{
+    const size_t bytes{ ELEMENTS_OFFSET + capacity * (sizeof(Element) + SKIPFIELDS_PER_SLOT * sizeof(Skipfield)) };
+    return (bytes + BLOCK_ALIGN - 1) / BLOCK_ALIGN;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::BlockPtr
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::allocate_block(size_t block_capacity)
+{
+    BlockAllocator block_alloc{ allocator_ };
+    BlockUnit* units{ BlockAllocTraits::allocate(block_alloc, block_units(block_capacity)) };
+
+    // the deleter frees the allocation if registering the block throws
+    BlockPtr new_block{ place_block(reinterpret_cast<std::byte*>(units), block_capacity), BlockDeleter{ block_alloc }};
+    if constexpr (Generational)
+        register_block(new_block.get());
+
+    // slots and skipfield entries are written as highest_untouched_ passes them
+    this->capacity_ += block_capacity;
+    count_event(&hive_counters::blocks_allocated);
+    return new_block;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::Block*
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::place_block(std::byte* bytes, size_t block_capacity) noexcept
+{
+    Block* block{ std::construct_at(reinterpret_cast<Block*>(bytes)) };
+    block->capacity_ = block_capacity;
+    block->elements_ = reinterpret_cast<Element*>(bytes + ELEMENTS_OFFSET);
+    block->skipfield_ = reinterpret_cast<Skipfield*>(bytes + ELEMENTS_OFFSET + block_capacity * sizeof(Element));
+    if constexpr (Generational)
+        block->generations_ = block->skipfield_ + block_capacity;
+    return block;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::BlockPtr
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::make_inline_block()
+    requires (InlineCapacity > 0)
+{
+    Block* block{ place_block(inline_.bytes_, InlineCapacity) };
+    if constexpr (Generational)
+    {
+        try
+        {
+            register_block(block);
+        }
+        catch (...)
+        {
+            std::destroy_at(block);
+            throw;
+        }
+    }
+
+    // free_block recognizes the embedded block, its deleter never runs
+    inline_.in_use_ = true;
+    this->capacity_ += InlineCapacity;
+    return BlockPtr{ block, BlockDeleter{ BlockAllocator{ allocator_ } } };
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::reserve(size_t new_capacity)
+{
+    // reserved blocks wait on the spare list, sized to what is still missing
+    while (capacity_ < new_capacity)
+    {
+        const size_t block_capacity{ std::clamp(new_capacity - capacity_, block_limits_.min, block_limits_.max) };
+        BlockPtr reserved{ allocate_block(block_capacity) };
+        reserved->next = std::move(spare_blocks_);
+        spare_blocks_ = std::move(reserved);
+        ++spare_block_count_;
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::set_block_capacity_limits(hive_limits limits)
+{
+    check_block_capacity_limits(limits);
+    block_limits_ = limits;
+    next_block_capacity_ = std::clamp(next_block_capacity_, limits.min, limits.max);
+
+    // spares outside the new limits would hand out wrongly sized blocks
+    BlockPtr kept;
+    Block* kept_tail{ nullptr };
+    while (spare_blocks_ != nullptr)
+    {
+        if (spare_blocks_->capacity_ < limits.min || spare_blocks_->capacity_ > limits.max)
+        {
+            free_spare_block();
+            continue;
+        }
+
+        BlockPtr spare{ std::move(spare_blocks_) };
+        spare_blocks_ = std::move(spare->next);
+        Block* raw_spare{ spare.get() };
+        if (kept_tail != nullptr)
+            kept_tail->next = std::move(spare);
+        else
+            kept = std::move(spare);
+        kept_tail = raw_spare;
+    }
+    spare_blocks_ = std::move(kept);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::set_growth_factor(double factor)
+{
+    if (!(factor >= 1.0))
+        throw std::invalid_argument("Growth factor must be at least 1.");
+    growth_factor_ = factor;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::check_block_capacity_limits(hive_limits limits)
+{
+    const hive_limits hard{ block_capacity_hard_limits() };
+    if (limits.min > limits.max || limits.min < hard.min || limits.max > hard.max)
+        throw std::length_error("Block capacity limits outside of hard limits.");
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::begin() noexcept
+{
+    return begin_block_ != nullptr ? iterator(begin_block_, begin_idx_) : end();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::const_iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::begin() const noexcept
+{
+    return begin_block_ != nullptr ? const_iterator(begin_block_, begin_idx_) : end();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::update_begin_on_emplace(Block* block, size_t idx) noexcept
+{
+    // only an element placed before the cached begin can become the new begin
+    if (begin_block_ == nullptr ||
+        block->serial_ < begin_block_->serial_ ||
+        (block == begin_block_ && idx < begin_idx_))
+    {
+        begin_block_ = block;
+        begin_idx_ = idx;
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::insert(const T& obj)
+{
+    return emplace(obj);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::insert(T&& obj)
+{
+    return emplace(std::move(obj));
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<std::input_iterator It, std::sentinel_for<It> Sent>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::insert(It first, Sent last)
+{
+    // single pass ranges cannot be counted up front
+    if constexpr (!std::forward_iterator<It> && !std::sized_sentinel_for<Sent, It>)
+    {
+        for (; first != last; ++first)
+            emplace(*first);
+    }
+    else
+    {
+        const auto count = static_cast<size_t>(std::ranges::distance(first, last));
+        insert_bulk(count, [this, &first](Element* slots, size_t run)
+        {
+            constexpr bool memcpy_source = TRIVIAL_COPY &&
+                                           std::contiguous_iterator<It> &&
+                                           std::same_as<std::iter_value_t<It>, T> &&
+                                           sizeof(Element) == sizeof(T);
+            if constexpr (memcpy_source)
+            {
+                std::memcpy(static_cast<void*>(slots), std::to_address(first), run * sizeof(T));
+                first += static_cast<std::iter_difference_t<It>>(run);
+            }
+            else
+            {
+                size_t constructed{ };
+                try
+                {
+                    for (; constructed<run; ++constructed, ++first)
+                        AllocTraits::construct(allocator_, &slots[constructed].data, *first);
+                }
+                catch (...)
+                {
+                    for (size_t i{}; i<constructed; ++i)
+                        AllocTraits::destroy(allocator_, &slots[i].data);
+                    throw;
+                }
+            }
+        });
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::insert(size_t count, const T& obj)
+{
+    insert_bulk(count, [this, &obj](Element* slots, size_t run)
+    {
+        if constexpr (TRIVIAL_COPY)
+        {
+            // copy the bytes, a union member of trivially copyable type needs no construction
+            for (size_t i{}; i<run; ++i)
+                std::memcpy(static_cast<void*>(&slots[i].data), &obj, sizeof(T));
+        }
+        else
+        {
+            size_t constructed{ };
+            try
+            {
+                for (; constructed<run; ++constructed)
+                    AllocTraits::construct(allocator_, &slots[constructed].data, obj);
+            }
+            catch (...)
+            {
+                for (size_t i{}; i<constructed; ++i)
+                    AllocTraits::destroy(allocator_, &slots[i].data);
+                throw;
+            }
+        }
+    });
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Filler>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::insert_bulk(size_t count, Filler&& fill)
+{
+    // fill(slots, run) constructs run elements or cleans up after itself and throws,
+    // so every completed run stays inserted
+
+    // erased runs first, lowest block first, same as emplace
+    while (count > 0 && free_blocks_.first() != nullptr)
+    {
+        Block* block{ free_blocks_.first() };
+        const size_t idx{ block->free_list_head_ };
+        const size_t gap{ block->skipfield_[idx] };
+        const size_t run{ std::min(gap, count) };
+
+        const FreeLinks links{ block->elements_[idx].free_ };
+        try
+        {
+            fill(block->elements_ + idx, run);
+        }
+        catch (...)
+        {
+            block->elements_[idx].free_ = links;
+            throw;
+        }
+
+        std::fill_n(block->skipfield_ + idx, run, Skipfield{ 0 });
+        if (run < gap)
+        {
+            const auto new_gap = static_cast<Skipfield>(gap - run);
+            block->skipfield_[idx+run] = new_gap;
+            block->skipfield_[idx+gap-1] = new_gap;
+            free_blocks_.relink_free_run(block, idx+run, links);
+        }
+        else
+        {
+            free_blocks_.unlink_free_run(block, links);
+        }
+
+        block->active_count_ += run;
+        size_ += run;
+        count -= run;
+        count_event(&hive_counters::emplaced, run);
+        count_event(&hive_counters::free_list_hits, run);
+        update_begin_on_emplace(block, idx);
+    }
+
+    // then untouched slots, new blocks are sized for everything that is left
+    while (count > 0)
+    {
+        if (last_block_ == nullptr || last_block_->highest_untouched_ == last_block_->capacity_)
+        {
+            next_block_capacity_ = std::clamp(std::max(next_block_capacity_, count), block_limits_.min, block_limits_.max);
+            add_block();
+        }
+
+        Block* block{ last_block_ };
+        const size_t idx{ block->highest_untouched_ };
+        const size_t run{ std::min(block->capacity_ - idx, count) };
+
+        fill(block->elements_ + idx, run);
+
+        std::fill_n(block->skipfield_ + idx, run, Skipfield{ 0 });
+        block->highest_untouched_ += run;
+        block->active_count_ += run;
+        size_ += run;
+        count -= run;
+        count_event(&hive_counters::emplaced, run);
+        update_begin_on_emplace(block, idx);
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename... Args>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::emplace(Args&&... args)
+{
+    Block* free_parent{ nullptr };
     size_t free_idx{ };
 
-    if (free_list_head_ != nullptr)
+    if (free_blocks_.first() != nullptr)
+    {
+        // fill the lowest block with erased slots first so live elements stay packed
+        free_parent = free_blocks_.first();
+        free_idx = free_parent->free_list_head_;
+
+        // links are overwritten by the new element so read them first
+        const FreeLinks links{ free_parent->elements_[free_idx].free_ };
+        try
+        {
+            AllocTraits::construct(allocator_, &free_parent->elements_[free_idx].data, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            free_parent->elements_[free_idx].free_ = links;
+            throw;
+        }
+
+        free_blocks_.on_emplace(free_parent, free_idx, links);
+        count_event(&hive_counters::free_list_hits);
+    }
+    else
+    {
+        if (last_block_ == nullptr || last_block_->highest_untouched_ == last_block_->capacity_)
+        {
+            add_block();
+        }
+        free_parent = last_block_;
+        free_idx = free_parent->highest_untouched_;
+
+        //construct element within block
+        AllocTraits::construct(allocator_, &free_parent->elements_[free_idx].data, std::forward<Args>(args)...);
+
+        free_parent->skipfield_[free_idx] = 0;
+        ++free_parent->highest_untouched_;
+    }
+
+    ++free_parent->active_count_;
+    ++size_;
+    count_event(&hive_counters::emplaced);
+
+    update_begin_on_emplace(free_parent, free_idx);
+    return iterator(free_parent, free_idx);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::erase(iterator itr)
+{
+    if (itr.current_block_ == nullptr ||
+        itr.idx_in_block_ >= itr.current_block_->highest_untouched_ ||
+        itr.current_block_->skipfield_[itr.idx_in_block_] > 0)
+    {
+        return end();
+    }
+
+    auto block = itr.current_block_;
+    const size_t idx = itr.idx_in_block_;
+
+    // advance first, the skipfield around idx is rewritten below
+    ++itr;
+
+    if constexpr (!TRIVIAL_DESTROY)
+        AllocTraits::destroy(allocator_, &block->elements_[idx].data);
+    bump_generation(block, idx);
+
+    --size_;
+    --block->active_count_;
+    count_event(&hive_counters::erased);
+
+    if (block->active_count_ == 0)
+    {
+        release_block(block);
+
+        // itr can only be in the released block as its end position
+        if (itr.current_block_ == block)
+            itr = end();
+    }
+    else
+    {
+        free_blocks_.on_erase(block, idx);
+    }
+
+    // erasing the first element makes the next active one the new begin
+    if (block == begin_block_ && idx == begin_idx_)
+    {
+        begin_block_ = itr != end() ? itr.current_block_ : nullptr;
+        begin_idx_ = itr.idx_in_block_;
+    }
+
+    return itr;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::splice(hive& other)
+    requires (InlineCapacity == 0)
+{
+    if (this == &other || other.first_block_ == nullptr)
+        return;
+
+    if (!(allocator_ == other.allocator_))
+        throw std::invalid_argument("Cannot splice hives with unequal allocators.");
+
+    size_t moved_capacity{ };
+    size_t moved_blocks{ };
+    for (const Block* block = other.first_block_.get(); block != nullptr; block = block->next.get())
+    {
+        if (block->capacity_ < block_limits_.min || block->capacity_ > block_limits_.max)
+            throw std::length_error("Spliced block outside of block capacity limits.");
+        moved_capacity += block->capacity_;
+        ++moved_blocks;
+    }
+
+    if constexpr (Generational)
+    {
+        // reserve up front so moving blocks between tables cannot throw half way
+        table_.blocks_.reserve(table_.blocks_.size() + moved_blocks);
+        table_.floors_.reserve(table_.blocks_.size() + moved_blocks);
+        table_.free_indices_.reserve(table_.blocks_.capacity());
+    }
+
+    // serials keep increasing along the chain, the only per block work besides handle indices
+    size_t serial{ last_block_ != nullptr ? last_block_->serial_ + 1 : 0 };
+    for (Block* block = other.first_block_.get(); block != nullptr; block = block->next.get())
     {
-        free_element = free_list_head_;
-        free_list_head_ = free_list_head_->next_free_;
+        block->serial_ = serial++;
+        if constexpr (Generational)
+        {
+            // handles into other go stale, the block keeps its generations under a new index
+            other.retire_table_index(block);
+
+            block->table_index_ = table_.blocks_.size();
+            table_.blocks_.push_back(block);
+            table_.floors_.push_back(Skipfield{ 0 });
+        }
+    }
 
-        free_parent = free_element->parent;
-        free_idx = free_element - free_parent->elements_;
+    if (begin_block_ == nullptr)
+    {
+        begin_block_ = other.begin_block_;
+        begin_idx_ = other.begin_idx_;
     }
+
+    // all of other's blocks come later, so its free list of blocks goes after ours
+    free_blocks_.splice(other.free_blocks_);
+
+    other.first_block_->prev = last_block_;
+    if (last_block_ != nullptr)
+        last_block_->next = std::move(other.first_block_);
     else
+        first_block_ = std::move(other.first_block_);
+    last_block_ = other.last_block_;
+
+    size_ += other.size_;
+    capacity_ += moved_capacity;
+
+    other.last_block_ = nullptr;
+    other.begin_block_ = nullptr;
+    other.begin_idx_ = 0;
+    other.size_ = 0;
+    other.capacity_ -= moved_capacity;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+hive_stats hive<T, Allocator, Skipfield, Generational, InlineCapacity>::stats() const
+{
+    hive_stats result;
+    result.size = size_;
+    result.capacity = capacity_;
+    result.spare_block_count = spare_block_count_;
+    for (const Block* spare = spare_blocks_.get(); spare != nullptr; spare = spare->next.get())
+        if (!is_inline(spare))
+            result.bytes_allocated += block_units(spare->capacity_) * BLOCK_ALIGN;
+
+    for (const Block* block = first_block_.get(); block != nullptr; block = block->next.get())
     {
-        if (last_block_ == nullptr || last_block_->active_count_ == last_block_->capacity_)
+        hive_block_stats block_stats{ block->capacity_, block->active_count_, block->highest_untouched_, 0 };
+
+        const Skipfield* skip{ block->skipfield_ };
+        for (size_t idx{}; idx<block->highest_untouched_; )
         {
-            add_block();
+            if (skip[idx] == 0)
+            {
+                idx = hive_detail::find_nonzero(skip, idx + 1, block->highest_untouched_);
+                continue;
+            }
+
+            const size_t run{ skip[idx] };
+            const auto bucket{ static_cast<size_t>(std::bit_width(run) - 1) };
+            if (bucket >= result.erased_run_histogram.size())
+                result.erased_run_histogram.resize(bucket + 1);
+            ++result.erased_run_histogram[bucket];
+            ++block_stats.erased_runs;
+            result.erased_slots += run;
+            idx += run;
         }
-        free_parent = last_block_;
 
-        free_idx = free_parent->highest_untouched_;
-        free_element = &free_parent->elements_[free_idx];
-        ++free_parent->highest_untouched_;
+        for (size_t idx{ block->free_list_head_ }; idx != NO_FREE; idx = block->elements_[idx].free_.next)
+            ++result.free_list_length;
+        if (block->free_list_head_ != NO_FREE)
+            ++result.blocks_with_free;
+
+        result.blocks.push_back(block_stats);
+        if (!is_inline(block))
+            result.bytes_allocated += block_units(block->capacity_) * BLOCK_ALIGN;
     }
+    result.block_count = result.blocks.size();
 
-    //construct element within block
-    AllocTraits::construct(allocator_, &free_element->data, std::forward<Args>(args)...);
+    if constexpr (Generational)
+    {
+        result.bytes_allocated += table_.blocks_.capacity() * sizeof(Block*) +
+                                  table_.floors_.capacity() * sizeof(Skipfield) +
+                                  table_.free_indices_.capacity() * sizeof(size_t);
+    }
+    return result;
+}
 
-    ++free_parent->active_count_;
-    ++size_;
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Relocate>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::compact(Relocate relocate)
+{
+    compact_step(std::numeric_limits<size_t>::max(), relocate);
+}
 
-    update_skipfield_on_emplace(free_parent, free_idx);
-    return iterator(free_parent, free_idx);
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Relocate>
+bool hive<T, Allocator, Skipfield, Generational, InlineCapacity>::compact_step(size_t max_moves, Relocate relocate)
+{
+    // blocks emptied here are freed rather than kept as spares
+    const size_t spares_before{ spare_block_count_ };
+
+    bool done{ false };
+    for (size_t moves{}; ; ++moves)
+    {
+        // the first free block is the lowest block with a hole, done once it is the last block
+        if (begin_block_ == nullptr || free_blocks_.first() == nullptr || free_blocks_.first() == last_block_)
+        {
+            done = true;
+            break;
+        }
+        if (moves == max_moves)
+            break;
+
+        iterator last{ end() };
+        --last;
+
+        // a move that throws leaves the element in place and its target slot free
+        T* old{ &*last };
+        iterator moved;
+        try
+        {
+            moved = emplace(std::move(*last));
+        }
+        catch (...)
+        {
+            while (spare_block_count_ > spares_before)
+                free_spare_block();
+            throw;
+        }
+        relocate(old, &*moved);
+        erase(last);
+    }
+
+    while (spare_block_count_ > spares_before)
+        free_spare_block();
+    return done;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Compare>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::sort(Compare comp)
+{
+    if (size_ < 2)
+        return;
+
+    if constexpr (TRIVIAL_COPY)
+    {
+        // values are sorted in a contiguous copy, then written back a run at a time
+        std::vector<T> sorted;
+        sorted.reserve(size_);
+        for (const Block* block = first_block_.get(); block != nullptr; block = block->next.get())
+        {
+            hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_, [&](size_t first, size_t last)
+            {
+                for (; first < last; ++first)
+                    sorted.push_back(block->elements_[first].data);
+            });
+        }
+        std::sort(sorted.begin(), sorted.end(), comp);
+
+        const T* src{ sorted.data() };
+        for (Block* block = first_block_.get(); block != nullptr; block = block->next.get())
+        {
+            hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_, [&](size_t first, size_t last)
+            {
+                if constexpr (CONTIGUOUS_SEGMENTS)
+                {
+                    std::memcpy(static_cast<void*>(&block->elements_[first].data), src, (last - first) * sizeof(T));
+                    src += last - first;
+                }
+                else
+                {
+                    for (; first < last; ++first)
+                        std::memcpy(static_cast<void*>(&block->elements_[first].data), src++, sizeof(T));
+                }
+            });
+        }
+    }
+    else if constexpr (SORT_BY_MOVE)
+    {
+        // values are moved out, sorted and moved back, a throwing comp still leaves every
+        // value in the hive
+        std::vector<T*> slots;
+        slots.reserve(size_);
+        for (Block* block = first_block_.get(); block != nullptr; block = block->next.get())
+        {
+            hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_, [&](size_t first, size_t last)
+            {
+                for (; first < last; ++first)
+                    slots.push_back(&block->elements_[first].data);
+            });
+        }
+        std::vector<T> sorted;
+        sorted.reserve(size_);
+        for (T* slot : slots)
+            sorted.push_back(std::move(*slot));
+
+        const auto move_back = [&]
+        {
+            for (size_t i{}; i<slots.size(); ++i)
+                *slots[i] = std::move(sorted[i]);
+        };
+        try
+        {
+            std::sort(sorted.begin(), sorted.end(), comp);
+        }
+        catch (...)
+        {
+            move_back();
+            throw;
+        }
+        move_back();
+    }
+    else
+    {
+        // slot pointers in iteration order, sorted by the values they point at
+        struct Slot
+        {
+            T* ptr;
+            size_t idx;
+        };
+        std::vector<Slot> slots;
+        slots.reserve(size_);
+        for (Block* block = first_block_.get(); block != nullptr; block = block->next.get())
+        {
+            hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_, [&](size_t first, size_t last)
+            {
+                for (; first < last; ++first)
+                    slots.push_back(Slot{ &block->elements_[first].data, slots.size() });
+            });
+        }
+        std::vector<T*> targets(slots.size());
+        std::ranges::transform(slots, targets.begin(), &Slot::ptr);
+        std::sort(slots.begin(), slots.end(), [&comp](const Slot& a, const Slot& b) { return comp(*a.ptr, *b.ptr); });
+
+        // targets[i] receives the element at slots[i], follow each cycle with one element
+        // held aside, a slot whose source is itself is placed
+        for (size_t start{}; start<slots.size(); ++start)
+        {
+            if (slots[start].idx == start)
+                continue;
+
+            T held{ std::move(*targets[start]) };
+            size_t idx{ start };
+            for (; slots[idx].idx != start; idx = std::exchange(slots[idx].idx, idx))
+                *targets[idx] = std::move(*slots[idx].ptr);
+            *targets[idx] = std::move(held);
+            slots[idx].idx = idx;
+        }
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename BinaryPredicate>
+size_t hive<T, Allocator, Skipfield, Generational, InlineCapacity>::unique(BinaryPredicate pred)
+{
+    const size_t old_size{ size_ };
+    if (old_size < 2)
+        return 0;
+
+    // each run of duplicates goes through one range erase, which can move end() when it
+    // empties the last block
+    iterator kept{ begin() };
+    while (kept != end())
+    {
+        iterator dup_last{ std::next(kept) };
+        while (dup_last != end() && pred(*kept, *dup_last))
+            ++dup_last;
+
+        if (dup_last != std::next(kept))
+        {
+            const bool to_end{ dup_last == end() };
+            erase(std::next(kept), dup_last);
+            if (to_end)
+                break;
+        }
+        kept = dup_last;
+    }
+    return old_size - size_;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<std::unsigned_integral Word>
+auto hive<T, Allocator, Skipfield, Generational, InlineCapacity>::get_handle(const_iterator itr) const -> basic_handle<Word>
+    requires Generational
+{
+    const Block* block{ itr.current_block_ };
+    if (block->table_index_ >= basic_handle<Word>::MAX_BLOCKS)
+        throw std::length_error("Too many blocks for handle width.");
+
+    const size_t idx{ itr.idx_in_block_ };
+    return basic_handle<Word>{ block->table_index_, block->generations_[idx], idx };
 }
 
-template<typename T, typename Allocator>
-void hive<T, Allocator>::update_skipfield_on_emplace(Block* block, size_t idx)
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<std::unsigned_integral Word>
+const T* hive<T, Allocator, Skipfield, Generational, InlineCapacity>::get(basic_handle<Word> h) const
+    requires Generational
 {
-   Element& new_element = block->elements_[idx]; 
-   size_t old_skip = new_element.skip;
-   new_element.skip = 0;
+    // the null handle's block index is never valid
+    if (h.block() >= table_.blocks_.size())
+        return nullptr;
+
+    const Block* block{ table_.blocks_[h.block()] };
+    if (block == nullptr)
+        return nullptr;
 
-   if (old_skip > 1) [[likely]]
-   {
-        --old_skip;
-        if (idx+1 < block->capacity_) [[likely]]
-            block->elements_[idx+1].skip = old_skip;
-        block->elements_[idx+old_skip].skip = old_skip;
-   }
+    const size_t idx{ h.slot() };
+    if (idx >= block->highest_untouched_ || block->skipfield_[idx] != 0)
+        return nullptr;
+    if ((Word(block->generations_[idx]) & basic_handle<Word>::mask(basic_handle<Word>::GENERATION_BITS)) != h.generation())
+        return nullptr;
+
+    return &block->elements_[idx].data;
 }
 
-template<typename T, typename Allocator>
-typename hive<T, Allocator>::iterator
-hive<T, Allocator>::erase(iterator itr)
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::iterator
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::erase(const_iterator first, const_iterator last)
 {
-    if (itr.current_block_ == nullptr || 
-        itr.current_block_->elements_[itr.idx_in_block_].skip > 0)
+    // erasing never moves an active last, end is looked up again since its block may be released
+    iterator result(const_cast<Block*>(last.current_block_), last.idx_in_block_);
+    if (first == last)
+        return result;
+    const bool last_is_end{ last == cend() };
+
+    auto erase_all = [](const T&) { return true; };
+    Block* block = const_cast<Block*>(first.current_block_);
+    size_t idx = first.idx_in_block_;
+    while (block != nullptr)
     {
-        return end();
+        const bool last_block_in_range = block == last.current_block_;
+        const size_t end_idx = last_block_in_range ? last.idx_in_block_ : block->highest_untouched_;
+
+        Block* next = block->next.get();
+        erase_in_block(block, idx, end_idx, erase_all);
+
+        if (last_block_in_range)
+            break;
+        block = next;
+        idx = 0;
     }
 
-    auto block = itr.current_block_;
-    const size_t idx = itr.idx_in_block_;
-    Element& element_to_erase = block->elements_[idx];
+    reset_begin();
+    return last_is_end ? end() : result;
+}
 
-    AllocTraits::destroy(allocator_, &element_to_erase.data);
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Pred>
+size_t hive<T, Allocator, Skipfield, Generational, InlineCapacity>::erase_where(Pred& pred)
+{
+    const size_t old_size = size_;
 
-    element_to_erase.next_free_ = free_list_head_;
-    free_list_head_ = &element_to_erase;
+    Block* block = first_block_.get();
+    while (block != nullptr)
+    {
+        Block* next = block->next.get();
+        erase_in_block(block, 0, block->highest_untouched_, pred);
+        block = next;
+    }
 
-    update_skipfield_on_erase(block, idx);
+    reset_begin();
+    return old_size - size_;
+}
 
-    --size_;
-    --block->active_count_;
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Pred>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::erase_in_block(Block* block, size_t idx, size_t end_idx, Pred& pred)
+{
+    // runs of consecutive matches are destroyed together and get one skipfield update
+    Skipfield* skip = block->skipfield_;
+    while (idx < end_idx)
+    {
+        if (skip[idx] != 0)
+        {
+            idx += skip[idx];
+            continue;
+        }
+        if (!pred(std::as_const(block->elements_[idx].data)))
+        {
+            ++idx;
+            continue;
+        }
 
-    ++itr;
-    return itr;
+        const size_t run_start = idx;
+        bool stopped_on_kept{ false };
+        while (true)
+        {
+            if constexpr (!TRIVIAL_DESTROY)
+                AllocTraits::destroy(allocator_, &block->elements_[idx].data);
+            bump_generation(block, idx);
+            ++idx;
+            if (idx >= end_idx || skip[idx] != 0)
+                break;
+            if (!pred(std::as_const(block->elements_[idx].data)))
+            {
+                stopped_on_kept = true;
+                break;
+            }
+        }
+
+        const size_t run = idx - run_start;
+        size_ -= run;
+        count_event(&hive_counters::erased, run);
+        block->active_count_ -= run;
+        if (block->active_count_ == 0)
+        {
+            release_block(block);
+            return;
+        }
+
+        // the old right gap start is stale once merged, so step over it now
+        const size_t right_gap = idx < block->highest_untouched_ ? skip[idx] : 0;
+        free_blocks_.on_erase(block, run_start, run);
+        idx += stopped_on_kept ? 1 : right_gap;
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::reset_begin() noexcept
+{
+    // emptied blocks are released, so the first block holds the first active element
+    const_iterator first(first_block_.get(), 0);
+    first.skip_to_active();
+    begin_block_ = first != cend() ? const_cast<Block*>(first.current_block_) : nullptr;
+    begin_idx_ = first.idx_in_block_;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::release_block(Block* block) noexcept
+{
+    BlockPtr owned{ hive_detail::detach_block(first_block_, last_block_, free_blocks_, block) };
+
+    if (spare_block_count_ < spare_block_limit_)
+    {
+        owned->next = std::move(spare_blocks_);
+        spare_blocks_ = std::move(owned);
+        ++spare_block_count_;
+    }
+    else
+    {
+        capacity_ -= block->capacity_;
+        free_block(std::move(owned));
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::destroy_elements() noexcept
+{
+    // without destructors to run, clearing only frees the blocks
+    if constexpr (!TRIVIAL_DESTROY)
+    {
+        Block* curr_block = first_block_.get();
+        while (curr_block != nullptr)
+        {
+            hive_detail::for_each_active_run(curr_block->skipfield_, 0, curr_block->highest_untouched_,
+                                             [this, curr_block](size_t first, size_t last)
+            {
+                for (size_t i{ first }; i<last; ++i)
+                    AllocTraits::destroy(allocator_, &curr_block->elements_[i].data);
+            });
+
+            curr_block = curr_block->next.get();
+        }
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::reset_chain() noexcept
+{
+    spare_block_count_ = 0;
+    last_block_ = nullptr;
+    free_blocks_.reset();
+    begin_block_ = nullptr;
+    begin_idx_ = 0;
+    size_ = 0;
+    capacity_ = 0;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::drop() noexcept
+    requires std::same_as<Allocator, std::pmr::polymorphic_allocator<T>>
+{
+    destroy_elements();
+
+    // the blocks' memory belongs to the allocator's resource now, nothing walks the chain
+    static_cast<void>(first_block_.release());
+    static_cast<void>(spare_blocks_.release());
+    if constexpr (Generational)
+        table_ = BlockTable{ };
+    if constexpr (InlineCapacity > 0)
+        inline_.in_use_ = false;
+    reset_chain();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::free_chain(BlockPtr& chain) noexcept
+{
+    // unlink one block at a time, destroying the chain through next would recurse per block
+    while (chain != nullptr)
+    {
+        BlockPtr doomed{ std::move(chain) };
+        chain = std::move(doomed->next);
+        free_block(std::move(doomed));
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::free_block(BlockPtr block) noexcept
+{
+    if constexpr (Generational)
+        retire_table_index(block.get());
+
+    if constexpr (InlineCapacity > 0)
+    {
+        if (is_inline(block.get()))
+        {
+            std::destroy_at(block.release());
+            inline_.in_use_ = false;
+        }
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::retire_table_index(const Block* block) noexcept
+{
+    // stale handles to this index must not match whichever block gets it next
+    table_.blocks_[block->table_index_] = nullptr;
+    table_.floors_[block->table_index_] = static_cast<Skipfield>(block->max_generation_ + 1);
+    table_.free_indices_.push_back(block->table_index_); // capacity reserved when the index was made
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::free_spare_block() noexcept
+{
+    capacity_ -= spare_blocks_->capacity_;
+    --spare_block_count_;
+
+    BlockPtr doomed{ std::move(spare_blocks_) };
+    spare_blocks_ = std::move(doomed->next);
+    free_block(std::move(doomed));
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::register_block(Block* block)
+{
+    if (table_.free_indices_.empty())
+    {
+        table_.blocks_.push_back(nullptr);
+        table_.floors_.push_back(Skipfield{ 0 });
+        // free_block must never allocate, keep room for every index to be free at once
+        table_.free_indices_.reserve(table_.blocks_.capacity());
+        table_.free_indices_.push_back(table_.blocks_.size() - 1);
+    }
+
+    block->table_index_ = table_.free_indices_.back();
+    table_.free_indices_.pop_back();
+    table_.blocks_[block->table_index_] = block;
+
+    block->max_generation_ = table_.floors_[block->table_index_];
+    std::fill_n(block->generations_, block->capacity_, block->max_generation_);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::bump_generation(Block* block, size_t idx) noexcept
+{
+    if constexpr (Generational)
+    {
+        const auto generation = static_cast<Skipfield>(block->generations_[idx] + 1);
+        block->generations_[idx] = generation;
+        block->max_generation_ = std::max(block->max_generation_, generation);
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::trim_capacity(size_t min_capacity) noexcept
+{
+    while (spare_blocks_ != nullptr && capacity_ - spare_blocks_->capacity_ >= min_capacity)
+        free_spare_block();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::set_spare_block_limit(size_t limit) noexcept
+{
+    spare_block_limit_ = limit;
+    while (spare_block_count_ > spare_block_limit_)
+        free_spare_block();
+}
+
+
+    /* --- Non-member Functions --- */
+
+// Erases every element matching pred in one sweep, returns the number erased
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity, typename Pred>
+size_t erase_if(hive<T, Allocator, Skipfield, Generational, InlineCapacity>& h, Pred pred)
+{
+    return h.erase_where(pred);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity, typename U>
+size_t erase(hive<T, Allocator, Skipfield, Generational, InlineCapacity>& h, const U& value)
+{
+    return erase_if(h, [&value](const T& elem) { return elem == value; });
+}
+
+
+    /* --- Parallel Traversal --- */
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Func>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::visit_block(Block* block, Func& func)
+{
+    // elements of an active run are visited without touching the skipfield
+    hive_detail::for_each_active_run(block->skipfield_, 0, block->highest_untouched_,
+                                     [block, &func](size_t first, size_t last)
+    {
+        for (size_t idx{ first }; idx<last; ++idx)
+            func(block->elements_[idx].data);
+    });
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+std::vector<typename hive<T, Allocator, Skipfield, Generational, InlineCapacity>::Block*>
+hive<T, Allocator, Skipfield, Generational, InlineCapacity>::partition_blocks(size_t max_threads, const hive_thread_pool& pool) const
+{
+    // chunk i covers the blocks [starts[i], starts[i+1]), the last entry is nullptr
+    size_t threads{ max_threads != 0 ? max_threads : pool.worker_count() + 1 };
+    threads = std::min(threads, std::max<size_t>(1, size_ / MIN_PARALLEL_CHUNK));
+
+    // greedy split, a chunk closes once it holds its share of active elements
+    std::vector<Block*> chunk_starts{ first_block_.get() };
+    const size_t share{ (size_ + threads - 1) / threads };
+    size_t in_chunk{ };
+    for (Block* block = first_block_.get(); block != nullptr && threads > 1; block = block->next.get())
+    {
+        in_chunk += block->active_count_;
+        if (in_chunk >= share && block->next != nullptr && chunk_starts.size() < threads)
+        {
+            chunk_starts.push_back(block->next.get());
+            in_chunk = 0;
+        }
+    }
+    chunk_starts.push_back(nullptr);
+    return chunk_starts;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename ChunkFunc>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::run_chunks(const std::vector<Block*>& chunk_starts, ChunkFunc& run_chunk,
+                                                                         hive_thread_pool& pool)
+{
+    // run_chunk(chunk, first, stop), a throwing chunk is reported once all have finished
+    const size_t chunks{ chunk_starts.size() - 1 };
+    std::vector<std::exception_ptr> errors(chunks);
+    auto task = [&](size_t chunk)
+    {
+        try { run_chunk(chunk, chunk_starts[chunk], chunk_starts[chunk+1]); }
+        catch (...) { errors[chunk] = std::current_exception(); }
+    };
+    pool.run(chunks, task);
+
+    for (const auto& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Func>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::parallel_for_each(Func func, size_t max_threads, hive_thread_pool& pool)
+{
+    auto run_chunk = [&func](size_t, Block* first, Block* stop)
+    {
+        Func local_func{ func };
+        for (Block* block = first; block != stop; block = block->next.get())
+            visit_block(block, local_func);
+    };
+    run_chunks(partition_blocks(max_threads, pool), run_chunk, pool);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Func>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::parallel_for_each(Func func, size_t max_threads, hive_thread_pool& pool) const
+{
+    auto run_chunk = [&func](size_t, Block* first, Block* stop)
+    {
+        Func local_func{ func };
+        auto visit = [&local_func](const T& elem) { local_func(elem); };
+        for (Block* block = first; block != stop; block = block->next.get())
+            visit_block(block, visit);
+    };
+    run_chunks(partition_blocks(max_threads, pool), run_chunk, pool);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename Func>
+void hive<T, Allocator, Skipfield, Generational, InlineCapacity>::parallel_transform(Func func, size_t max_threads, hive_thread_pool& pool)
+{
+    parallel_for_each([func](T& elem) mutable { elem = func(std::as_const(elem)); }, max_threads, pool);
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename R, typename Reduce, typename Map>
+R hive<T, Allocator, Skipfield, Generational, InlineCapacity>::parallel_transform_reduce(R init, Reduce reduce, Map map, size_t max_threads,
+                                                                                      hive_thread_pool& pool) const
+{
+    // each chunk folds into its own slot, the slots are combined in block order afterwards
+    const std::vector<Block*> chunk_starts{ partition_blocks(max_threads, pool) };
+    std::vector<std::optional<R>> partials(chunk_starts.size() - 1);
+    auto run_chunk = [&](size_t chunk, Block* first, Block* stop)
+    {
+        std::optional<R> partial;
+        auto fold = [&](const T& elem)
+        {
+            if (partial.has_value())
+                partial = reduce(std::move(*partial), map(elem));
+            else
+                partial.emplace(map(elem));
+        };
+        for (Block* block = first; block != stop; block = block->next.get())
+            visit_block(block, fold);
+        partials[chunk] = std::move(partial);
+    };
+    run_chunks(chunk_starts, run_chunk, pool);
+
+    for (auto& partial : partials)
+    {
+        if (partial.has_value())
+            init = reduce(std::move(init), std::move(*partial));
+    }
+    return init;
 }
 
-template<typename T, typename Allocator>
-void hive<T, Allocator>::update_skipfield_on_erase(Block* block, size_t idx)
+template<typename T, typename Allocator, hive_skipfield Skipfield, bool Generational, size_t InlineCapacity>
+template<typename R, typename Reduce>
+R hive<T, Allocator, Skipfield, Generational, InlineCapacity>::parallel_reduce(R init, Reduce reduce, size_t max_threads,
+                                                                            hive_thread_pool& pool) const
 {
-    size_t left_gap{ };
-    size_t right_gap{ };
+    return parallel_transform_reduce(std::move(init), std::move(reduce), [](const T& elem) -> const T& { return elem; }, max_threads, pool);
+}
 
-    // if next block is active (skip == 0) then no change else coalesce
-    if (idx+1 < block->highest_untouched_)
-        right_gap = block->elements_[idx+1].skip;
 
-    // if empty element to our left coalesce with it as well
-    if (idx>0)
-        left_gap = block->elements_[idx-1].skip;
+    /* --- Small Hive Alias --- */
 
-    //update idx-left_gap+1 to left_gap+right_gap+1
-    //update idx+right_gap-1 to left_gap+right_gap+1
-    const size_t new_gap = left_gap + 1 + right_gap;
+// Hive whose first block of N slots lives inside the hive object, so hives of up to
+// N elements never allocate. Moving one that uses its embedded block moves the elements.
+template<typename T, size_t N, typename Allocator = std::allocator<T>>
+using small_hive = hive<T, Allocator, std::uint16_t, false, N>;
 
-    block->elements_[idx-left_gap].skip = new_gap;
-    block->elements_[idx+right_gap].skip = new_gap;
-}
\ No newline at end of file
+
+    /* --- Polymorphic Allocator Alias --- */
+
+namespace pmr
+{
+    template<typename T, hive_skipfield Skipfield = std::uint16_t>
+    using hive = ::hive<T, std::pmr::polymorphic_allocator<T>, Skipfield>;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Size of a transparent huge page on x86-64 and most aarch64 kernels
+inline constexpr size_t huge_page_bytes{ size_t{ 1 } << 21 };
+
+// Allocator for very large hives, e.g. hive<T, huge_page_allocator<T>, std::uint32_t>.
+// Allocations of at least MapThreshold bytes get their own anonymous mapping, rounded
+// up to whole huge pages so they start on a huge page boundary. MAP_HUGETLB is tried
+// first, then a normal mapping marked MADV_HUGEPAGE so transparent huge pages can back
+// it. Mappings are returned with munmap. Smaller allocations, and every allocation
+// off Linux, use std::allocator.
+template<typename T, size_t MapThreshold = huge_page_bytes>
+class huge_page_allocator
+{
+    // every mapping is rounded up to whole huge pages, a lower threshold would spend a
+    // 2 MiB mapping on allocations smaller than that
+    static_assert(MapThreshold >= huge_page_bytes, "Only allocations of a huge page or more are mapped.");
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = huge_page_allocator<U, MapThreshold>;
+    };
+
+    huge_page_allocator() = default;
+    template<typename U>
+    huge_page_allocator(const huge_page_allocator<U, MapThreshold>&) noexcept { }
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+#if defined(__linux__)
+        if (n * sizeof(T) >= MapThreshold)
+            return static_cast<T*>(map(mapped_bytes(n)));
+#endif
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+#if defined(__linux__)
+        if (n * sizeof(T) >= MapThreshold)
+        {
+            munmap(p, mapped_bytes(n));
+            return;
+        }
+#endif
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const huge_page_allocator<U, MapThreshold>&) const noexcept { return true; }
+
+    // true if the allocation of n elements gets its own mapping
+    [[nodiscard]] static constexpr bool is_mapped(size_t n) noexcept
+    {
+#if defined(__linux__)
+        return n * sizeof(T) >= MapThreshold;
+#else
+        static_cast<void>(n);
+        return false;
+#endif
+    }
+
+private:
+    static size_t mapped_bytes(size_t n) noexcept
+    {
+        return (n * sizeof(T) + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+    }
+
+#if defined(__linux__)
+    static void* map(size_t bytes)
+    {
+        static_assert(alignof(T) <= huge_page_bytes, "Mappings are only huge page aligned.");
+
+        // explicit huge pages only exist if the administrator reserved some
+        void* mem{ mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0) };
+        if (mem != MAP_FAILED)
+            return mem;
+
+        // over allocate by one huge page so the start can be aligned, then trim both ends
+        const size_t padded{ bytes + huge_page_bytes };
+        mem = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            throw std::bad_alloc();
+
+        const auto raw = reinterpret_cast<std::uintptr_t>(mem);
+        const auto aligned = (raw + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+        if (aligned != raw)
+            munmap(mem, aligned - raw);
+        if (const size_t tail{ raw + padded - (aligned + bytes) }; tail != 0)
+            munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+
+#if defined(MADV_HUGEPAGE)
+        madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<void*>(aligned);
+    }
+#endif
+};
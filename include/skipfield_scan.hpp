@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+#if !defined(HIVE_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+// Skipfield kernels shared by hive's iteration, counting and bulk visit paths.
+// Active slots hold 0 and the first slot of an erased run holds its non zero length,
+// so from an active slot the active run ends at the next non zero entry. That search
+// is what gets vectorized, the instruction set is picked at compile time:
+// AVX2 when enabled, else SSE2, else scalar. Define HIVE_NO_SIMD to force scalar.
+namespace hive_detail
+{
+
+template<typename S>
+[[nodiscard]] inline size_t find_nonzero_scalar(const S* skip, size_t first, size_t last) noexcept
+{
+    while (first < last && skip[first] == 0)
+        ++first;
+    return first;
+}
+
+#if !defined(HIVE_NO_SIMD) && defined(__AVX2__)
+template<typename S>
+[[nodiscard]] inline unsigned zero_mask(const S* slots) noexcept
+{
+    const __m256i v{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slots)) };
+    const __m256i zero{ _mm256_setzero_si256() };
+    if constexpr (sizeof(S) == 1)
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+    else if constexpr (sizeof(S) == 2)
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, zero)));
+    else
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(v, zero)));
+}
+inline constexpr size_t SIMD_BYTES{ 32 };
+inline constexpr unsigned ALL_ZERO{ ~0u };
+#elif !defined(HIVE_NO_SIMD) && defined(__SSE2__)
+template<typename S>
+[[nodiscard]] inline unsigned zero_mask(const S* slots) noexcept
+{
+    const __m128i v{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(slots)) };
+    const __m128i zero{ _mm_setzero_si128() };
+    if constexpr (sizeof(S) == 1)
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+    else if constexpr (sizeof(S) == 2)
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero)));
+    else
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi32(v, zero)));
+}
+inline constexpr size_t SIMD_BYTES{ 16 };
+inline constexpr unsigned ALL_ZERO{ 0xFFFF };
+#else
+inline constexpr size_t SIMD_BYTES{ 0 };
+inline constexpr unsigned ALL_ZERO{ 0 };
+#endif
+
+inline constexpr size_t SCALAR_PROBE{ 4 };
+
+// First index in [first, last) whose skip is non zero, or last
+template<typename S>
+[[nodiscard]] inline size_t find_nonzero(const S* skip, size_t first, size_t last) noexcept
+{
+    if constexpr (SIMD_BYTES != 0)
+    {
+        // short active runs are common when fragmented, check a few slots before a full vector
+        for (const size_t stop{ std::min(last, first + SCALAR_PROBE) }; first < stop; ++first)
+            if (skip[first] != 0)
+                return first;
+
+        constexpr size_t LANES{ SIMD_BYTES / sizeof(S) };
+        while (last - first >= LANES)
+        {
+            // each lane sets sizeof(S) mask bits, the trailing ones count zero bytes
+            const unsigned mask{ zero_mask(skip + first) };
+            if (mask != ALL_ZERO)
+                return first + static_cast<size_t>(std::countr_one(mask)) / sizeof(S);
+            first += LANES;
+        }
+    }
+    return find_nonzero_scalar(skip, first, last);
+}
+
+// Calls func(run_first, run_last) for every run of active slots in [first, last).
+// first must be an active slot or the first slot of an erased run.
+template<typename S, typename Func>
+inline void for_each_active_run(const S* skip, size_t first, size_t last, Func&& func)
+{
+    while (first < last)
+    {
+        first += skip[first];
+        if (first >= last)
+            return;
+
+        const size_t run_last{ find_nonzero(skip, first + 1, last) };
+        func(first, run_last);
+        first = run_last;
+    }
+}
+
+// Active slots in [first, last), same precondition as for_each_active_run
+template<typename S>
+[[nodiscard]] inline size_t count_active(const S* skip, size_t first, size_t last) noexcept
+{
+    size_t count{ };
+    for_each_active_run(skip, first, last, [&count](size_t run_first, size_t run_last)
+    {
+        count += run_last - run_first;
+    });
+    return count;
+}
+
+}
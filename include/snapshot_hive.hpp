@@ -0,0 +1,343 @@
+#pragma once
+
+#include "hive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Hive with one writer thread and any number of reader threads that never block it.
+// The writer emplaces, erases and then calls publish(), which records the runs of
+// active elements as an immutable snapshot. read() pins the latest snapshot and
+// iterates it while the writer keeps going. Erasures are deferred: an erased element
+// stays in place until no pinned snapshot can contain it, and only then does the hive
+// destroy it and reuse its slot or free its block. Readers therefore never see a
+// slot change under them. Elements are immutable once emplaced; to change one, erase
+// it and emplace the new value.
+//
+// Epochs: every snapshot carries the epoch it was published in. A reader pins the
+// current epoch in one of max_readers slots before loading the snapshot. The writer
+// frees snapshots and erases elements retired before the oldest pinned epoch.
+template <typename T, typename Allocator = std::allocator<T>, hive_skipfield Skipfield = std::uint16_t>
+class snapshot_hive
+{
+public:
+    using hive_type = hive<T, Allocator, Skipfield>;
+    using iterator = typename hive_type::iterator;
+
+    static constexpr size_t DEFAULT_MAX_READERS{ 64 };
+
+private:
+    // Segments are spans of T, or strided views over the hive's slots when T is narrower
+    // than the free list links. Runs keep the underlying slot pointer either way.
+    static constexpr bool CONTIGUOUS{ hive_type::CONTIGUOUS_SEGMENTS };
+
+    static auto segment_data(const typename hive_type::const_segment& seg) noexcept
+    {
+        if constexpr (CONTIGUOUS)
+            return seg.data();
+        else
+            return seg.base().data();
+    }
+
+    using Slot = std::remove_pointer_t<decltype(segment_data(std::declval<typename hive_type::const_segment>()))>;
+
+    [[nodiscard]] static const T& value(const Slot* slot) noexcept
+    {
+        if constexpr (CONTIGUOUS)
+            return *slot;
+        else
+            return slot->data;
+    }
+
+    struct Run
+    {
+        const Slot* first;
+        size_t count;
+    };
+
+    struct Snapshot
+    {
+        std::uint64_t epoch;
+        size_t size;
+        std::vector<Run> runs;
+    };
+
+    struct Retired
+    {
+        iterator itr;
+        std::uint64_t epoch;   // last epoch whose snapshot can hold the element
+    };
+
+    // 0 is an unused reader slot, epochs start at 1
+    static constexpr std::uint64_t IDLE{ 0 };
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<std::uint64_t> pinned{ IDLE };
+    };
+
+
+    /* --- Snapshot View --- */
+public:
+
+    // A pinned snapshot. Holding it delays reclamation, so readers should not keep it
+    // longer than a scan. Iteration yields the elements active at publish().
+    class snapshot
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const T*;
+            using reference         = const T&;
+
+            iterator() = default;
+
+            [[nodiscard]] reference operator*() const noexcept { return value(run_->first + idx_); }
+            [[nodiscard]] pointer operator->() const noexcept { return &**this; }
+
+            iterator& operator++() noexcept
+            {
+                if (++idx_ == run_->count)
+                {
+                    ++run_;
+                    idx_ = 0;
+                }
+                return *this;
+            }
+
+            iterator operator++(int) noexcept
+            {
+                iterator tmp{ *this };
+                ++*this;
+                return tmp;
+            }
+
+            [[nodiscard]] bool operator==(const iterator&) const noexcept = default;
+
+        private:
+            friend class snapshot;
+            const Run* run_{ nullptr };
+            size_t idx_{ };
+
+            // runs are never empty, so (run, 0) is an element or the end
+            explicit iterator(const Run* run) noexcept
+                : run_(run)
+            { }
+        };
+
+        snapshot(const snapshot&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+
+        snapshot(snapshot&& other) noexcept
+            : slot_(std::exchange(other.slot_, nullptr)),
+              view_(std::exchange(other.view_, nullptr))
+        { }
+
+        ~snapshot()
+        {
+            if (slot_ != nullptr)
+                slot_->pinned.store(IDLE, std::memory_order_release);
+        }
+
+        [[nodiscard]] std::uint64_t epoch() const noexcept { return view_->epoch; }
+        [[nodiscard]] size_t size() const noexcept { return view_->size; }
+        [[nodiscard]] bool is_empty() const noexcept { return view_->size == 0; }
+
+        [[nodiscard]] iterator begin() const noexcept { return iterator{ view_->runs.data() }; }
+        [[nodiscard]] iterator end() const noexcept { return iterator{ view_->runs.data() + view_->runs.size() }; }
+
+    private:
+        friend class snapshot_hive;
+        ReaderSlot* slot_;
+        const Snapshot* view_;
+
+        snapshot(ReaderSlot* slot, const Snapshot* view) noexcept
+            : slot_(slot),
+              view_(view)
+        { }
+    };
+
+
+    /* --- Member Variables --- */
+private:
+    hive_type hive_;
+
+    std::unique_ptr<ReaderSlot[]> readers_;
+    size_t max_readers_;
+
+    // publish() stores the new snapshot before advancing the epoch, so a reader that
+    // pins epoch e loads a snapshot of epoch e or later
+    std::atomic<std::uint64_t> epoch_{ 1 };
+    std::atomic<const Snapshot*> current_{ nullptr };
+
+    // writer only: every snapshot not yet freed, oldest first, and deferred erasures
+    std::vector<std::unique_ptr<Snapshot>> snapshots_;
+    std::vector<Retired> retired_;
+
+
+    /* --- Special Member Functions --- */
+public:
+    explicit snapshot_hive(size_t max_readers = DEFAULT_MAX_READERS, const Allocator& alloc = Allocator())
+        : hive_(alloc),
+          readers_(std::make_unique<ReaderSlot[]>(std::max<size_t>(1, max_readers))),
+          max_readers_(std::max<size_t>(1, max_readers))
+    {
+        snapshots_.push_back(std::make_unique<Snapshot>(Snapshot{ 1, 0, { } }));
+        current_.store(snapshots_.back().get(), std::memory_order_release);
+    }
+
+    snapshot_hive(const snapshot_hive&) = delete;
+    snapshot_hive& operator=(const snapshot_hive&) = delete;
+
+    // Every snapshot must have been released
+    ~snapshot_hive() = default;
+
+
+    /* --- Writer Interface --- */
+
+    // Elements the writer has not erased, including ones not yet published
+    [[nodiscard]] size_t size() const noexcept { return hive_.size() - retired_.size(); }
+    [[nodiscard]] bool is_empty() const noexcept { return size() == 0; }
+
+    // Erased elements still waiting for readers of older snapshots
+    [[nodiscard]] size_t retired_count() const noexcept { return retired_.size(); }
+
+    template<typename... Args>
+    iterator emplace(Args&&... args) { return hive_.emplace(std::forward<Args>(args)...); }
+
+    // Hides the element from the next snapshot and erases it once no reader can see it.
+    // Each element must be erased at most once.
+    void erase(iterator itr) { retired_.push_back(Retired{ itr, epoch_.load(std::memory_order_relaxed) }); }
+
+    // Makes every emplace and erase so far visible to later read() calls, then reclaims
+    // whatever no pinned snapshot can reach. Each call rebuilds the run list from scratch:
+    // it walks every segment of the hive and sorts the pending erasures, O(size) when the
+    // hive is fragmented, so batch many writes per publish.
+    void publish();
+
+    // Reclaims without publishing, e.g. after readers finish while the writer is idle
+    void collect();
+
+
+    /* --- Reader Interface --- */
+
+    // Pins the latest snapshot, wait free unless all max_readers slots are taken,
+    // in which case it yields until one is released
+    [[nodiscard]] snapshot read() const;
+
+private:
+    [[nodiscard]] std::uint64_t oldest_pinned() const noexcept;
+};
+
+    /* --- Forward Declared Functions --- */
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+void snapshot_hive<T, Allocator, Skipfield>::publish()
+{
+    // retired elements are still active in the hive, cut them out of the runs
+    std::vector<const Slot*> hidden;
+    hidden.reserve(retired_.size());
+    for (const Retired& r : retired_)
+        hidden.push_back(reinterpret_cast<const Slot*>(&*r.itr));
+    std::ranges::sort(hidden, std::less<>{ });
+
+    const std::uint64_t epoch{ epoch_.load(std::memory_order_relaxed) + 1 };
+    auto next = std::make_unique<Snapshot>(Snapshot{ epoch, size(), { } });
+
+    // fragmented blocks yield an element per segment, adjacent ones are merged back
+    const auto add_run = [&runs = next->runs](const Slot* first, const Slot* last)
+    {
+        if (!runs.empty() && runs.back().first + runs.back().count == first)
+            runs.back().count += static_cast<size_t>(last - first);
+        else
+            runs.push_back(Run{ first, static_cast<size_t>(last - first) });
+    };
+    std::as_const(hive_).for_each_segment([&](const typename hive_type::const_segment& seg)
+    {
+        const Slot* first{ segment_data(seg) };
+        const Slot* const last{ first + seg.size() };
+        for (auto cut = std::ranges::lower_bound(hidden, first, std::less<>{ });
+             cut != hidden.end() && *cut < last; ++cut)
+        {
+            if (*cut != first)
+                add_run(first, *cut);
+            first = *cut + 1;
+        }
+        if (first != last)
+            add_run(first, last);
+    });
+
+    snapshots_.push_back(std::move(next));
+    current_.store(snapshots_.back().get(), std::memory_order_seq_cst);
+    epoch_.store(epoch, std::memory_order_seq_cst);
+
+    collect();
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+void snapshot_hive<T, Allocator, Skipfield>::collect()
+{
+    const std::uint64_t oldest{ oldest_pinned() };
+
+    // readers pinned at epoch e load snapshot e or later, older ones are unreachable
+    // and the newest is always kept
+    const auto stale = std::ranges::find_if(snapshots_, [oldest](const auto& s) { return s->epoch >= oldest; });
+    const auto keep_from = std::min(stale, std::prev(snapshots_.end()));
+    snapshots_.erase(snapshots_.begin(), keep_from);
+
+    // an element retired in epoch r is in the snapshots up to r, it goes once every pin
+    // is later and a later snapshot is current
+    std::erase_if(retired_, [&](const Retired& r)
+    {
+        if (r.epoch >= oldest || r.epoch == epoch_.load(std::memory_order_relaxed))
+            return false;
+        hive_.erase(r.itr);
+        return true;
+    });
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+std::uint64_t snapshot_hive<T, Allocator, Skipfield>::oldest_pinned() const noexcept
+{
+    std::uint64_t oldest{ std::numeric_limits<std::uint64_t>::max() };
+    for (size_t i{}; i<max_readers_; ++i)
+    {
+        const std::uint64_t pinned{ readers_[i].pinned.load(std::memory_order_seq_cst) };
+        if (pinned != IDLE)
+            oldest = std::min(oldest, pinned);
+    }
+    return oldest;
+}
+
+template<typename T, typename Allocator, hive_skipfield Skipfield>
+typename snapshot_hive<T, Allocator, Skipfield>::snapshot snapshot_hive<T, Allocator, Skipfield>::read() const
+{
+    // threads start at different slots so concurrent readers rarely collide
+    static std::atomic<size_t> next_thread_id{ };
+    thread_local const size_t thread_id{ next_thread_id.fetch_add(1, std::memory_order_relaxed) };
+
+    for (size_t attempt{}; ; ++attempt)
+    {
+        const size_t i{ (thread_id + attempt) % max_readers_ };
+        std::uint64_t expected{ IDLE };
+        const std::uint64_t epoch{ epoch_.load(std::memory_order_seq_cst) };
+        if (readers_[i].pinned.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst))
+            return snapshot{ &readers_[i], current_.load(std::memory_order_seq_cst) };
+
+        if (attempt % max_readers_ == max_readers_ - 1)
+            std::this_thread::yield();
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "hive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace hive_detail
+{
+
+// Narrowest skipfield whose blocks can hold N slots
+template<size_t N>
+[[nodiscard]] consteval auto narrowest_skipfield() noexcept
+{
+    if constexpr (N <= hive<char, std::allocator<char>, std::uint8_t>::MAX_BLOCK_CAPACITY)
+        return std::uint8_t{ };
+    else if constexpr (N <= hive<char, std::allocator<char>, std::uint16_t>::MAX_BLOCK_CAPACITY)
+        return std::uint16_t{ };
+    else
+        return std::uint32_t{ };
+}
+
+template<size_t N>
+using skipfield_for = decltype(narrowest_skipfield<N>());
+
+// Allocator for hives that must never reach the heap, allocating is a bug and throws
+template<typename T>
+struct no_heap_allocator
+{
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    no_heap_allocator() = default;
+    template<typename U>
+    no_heap_allocator(const no_heap_allocator<U>&) noexcept { }
+
+    [[nodiscard]] T* allocate(size_t) { throw std::bad_alloc(); }
+    void deallocate(T*, size_t) noexcept { }
+
+    template<typename U>
+    bool operator==(const no_heap_allocator<U>&) const noexcept { return true; }
+};
+
+}
+
+// Fixed capacity hive whose N slots live inside the object, for code that must not
+// allocate. It is a small_hive that never spills: the skipfield is the narrowest that
+// fits N, and emplace returns end() instead of growing once N elements are active.
+// Iterators, erase and the skipfield behave as in hive, and slots are only written
+// as they are first used, so neither construction nor emplace touches all N.
+// Operations that need scratch memory (sort, stats, reserve) are not available.
+template<typename T, size_t N>
+class static_hive : private hive<T, hive_detail::no_heap_allocator<T>, hive_detail::skipfield_for<N>, false, N>
+{
+    static_assert(N > 0, "A static hive needs at least one slot.");
+
+    using base = hive<T, hive_detail::no_heap_allocator<T>, hive_detail::skipfield_for<N>, false, N>;
+
+public:
+    using skipfield_type = hive_detail::skipfield_for<N>;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
+    using typename base::segment;
+    using typename base::const_segment;
+
+    static_hive() = default;
+
+    static_hive(std::initializer_list<T> il)
+    {
+        if (!insert(il.begin(), il.end()))
+            throw std::length_error("Initializer list exceeds static hive capacity.");
+    }
+
+    using base::is_empty;
+    using base::size;
+    [[nodiscard]] bool is_full() const noexcept { return size() == N; }
+    [[nodiscard]] static constexpr size_t capacity() noexcept { return N; }
+    [[nodiscard]] static constexpr size_t max_size() noexcept { return N; }
+
+    using base::begin;
+    using base::end;
+    using base::cbegin;
+    using base::cend;
+    using base::rbegin;
+    using base::rend;
+    using base::crbegin;
+    using base::crend;
+    using base::segments;
+    using base::for_each_segment;
+
+    // end() when full, nothing is constructed then
+    template<typename... Args>
+    iterator emplace(Args&&... args)
+    {
+        if (is_full())
+            return end();
+        return base::emplace(std::forward<Args>(args)...);
+    }
+
+    iterator insert(const T& value) { return emplace(value); }
+    iterator insert(T&& value) { return emplace(std::move(value)); }
+
+    // Inserts all or nothing, false if the elements do not fit
+    bool insert(size_t n, const T& value)
+    {
+        if (n > N - size())
+            return false;
+        base::insert(n, value);
+        return true;
+    }
+
+    template<std::forward_iterator It>
+    bool insert(It first, It last)
+    {
+        if (static_cast<size_t>(std::distance(first, last)) > N - size())
+            return false;
+        base::insert(first, last);
+        return true;
+    }
+
+    using base::erase;
+    using base::clear;
+    using base::unique;
+
+    void swap(static_hive& other) { base::swap(other); }
+    friend void swap(static_hive& a, static_hive& b) { a.swap(b); }
+
+    template<typename Pred>
+    friend size_t erase_if(static_hive& h, Pred pred) { return ::erase_if(static_cast<base&>(h), pred); }
+
+    template<typename U>
+    friend size_t erase(static_hive& h, const U& value) { return ::erase(static_cast<base&>(h), value); }
+};
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include "column_hive.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+TEST(ColumnHiveTest, EmplaceEraseKeepsColumnsInSync)
+{
+    column_hive<int, double, std::string> h;
+    std::vector<column_hive<int, double, std::string>::iterator> its;
+    for (int i{}; i<100; ++i)
+        its.push_back(h.emplace(i, i * 0.5, std::to_string(i)));
+    EXPECT_EQ(h.size(), 100);
+
+    for (int i{}; i<100; i += 3)
+        h.erase(its[static_cast<size_t>(i)]);
+    EXPECT_EQ(h.size(), 66);
+
+    for (auto [key, half, name] : h)
+    {
+        EXPECT_NE(key % 3, 0);
+        EXPECT_EQ(half, key * 0.5);
+        EXPECT_EQ(name, std::to_string(key));
+    }
+
+    // erased slots are reused and stay addressable through the same iterator
+    auto it = h.emplace(1000, 1.5, "new");
+    EXPECT_EQ(it.get<0>(), 1000);
+    EXPECT_EQ(it.get<2>(), "new");
+    EXPECT_EQ(h.size(), 67);
+    EXPECT_EQ(h.capacity(), 16 + 32 + 64);
+
+    // erase returns the following row
+    auto next = h.erase(h.begin());
+    EXPECT_EQ(next, h.begin());
+}
+
+TEST(ColumnHiveTest, ColumnSegments)
+{
+    column_hive<float, float, std::uint8_t> h;
+    std::vector<column_hive<float, float, std::uint8_t>::iterator> its;
+    for (int i{}; i<40; ++i)
+        its.push_back(h.emplace(static_cast<float>(i), 1.0f, std::uint8_t{ 7 }));
+    h.erase(its[5]);
+    h.erase(its[6]);
+    h.erase(its[20]);
+
+    // position += velocity over two columns only, every span of a run has the same size
+    size_t runs{ };
+    h.for_each_segment<0, 1>([&runs](std::span<float> pos, std::span<float> vel)
+    {
+        ASSERT_EQ(pos.size(), vel.size());
+        for (size_t i{}; i<pos.size(); ++i)
+            pos[i] += vel[i];
+        ++runs;
+    });
+    EXPECT_EQ(runs, 4);
+
+    float sum{ };
+    const auto& const_h = h;
+    const_h.for_each_segment<0>([&sum](std::span<const float> pos) { sum = std::accumulate(pos.begin(), pos.end(), sum); });
+    EXPECT_EQ(sum, static_cast<float>(40 * 41 / 2 - 6 - 7 - 21));
+
+    // no columns listed visits them all
+    size_t tags{ };
+    h.for_each_segment([&tags](std::span<float>, std::span<float>, std::span<std::uint8_t> tag) { tags += tag.size(); });
+    EXPECT_EQ(tags, h.size());
+}
+
+TEST(ColumnHiveTest, CopyMoveClear)
+{
+    column_hive<int, std::string> h;
+    for (int i{}; i<50; ++i)
+        h.emplace(i, std::string(20, static_cast<char>('a' + i % 26)));
+    h.erase(h.begin());
+
+    column_hive<int, std::string> copy{ h };
+    EXPECT_EQ(copy.size(), 49);
+    EXPECT_EQ(std::get<1>(*copy.begin()), std::string(20, 'b'));
+
+    column_hive<int, std::string> moved{ std::move(copy) };
+    EXPECT_TRUE(copy.is_empty());
+    EXPECT_EQ(moved.size(), 49);
+
+    moved.clear();
+    EXPECT_TRUE(moved.is_empty());
+    EXPECT_EQ(moved.begin(), moved.end());
+    moved.emplace(1, "x");
+    EXPECT_EQ(moved.size(), 1);
+
+    // erasing every row frees the blocks, the last one is kept for reuse
+    while (!h.is_empty())
+        h.erase(h.begin());
+    EXPECT_EQ(h.begin(), h.end());
+    EXPECT_GT(h.capacity(), 0);
+}
+
+TEST(ColumnHiveTest, LowestBlockReusedFirst)
+{
+    // blocks of 16, 32 and 64 rows
+    column_hive<int> h;
+    std::vector<column_hive<int>::iterator> its;
+    for (int i{}; i<112; ++i)
+        its.push_back(h.emplace(i));
+
+    h.erase(its[3]);
+    h.erase(its[100]);
+    h.emplace(-1);
+    EXPECT_EQ(std::get<0>(*std::next(h.begin(), 3)), -1);
+    h.emplace(-2);
+    EXPECT_EQ(std::get<0>(*std::next(h.begin(), 100)), -2);
+    EXPECT_EQ(h.capacity(), 112);
+}
+
+struct ColumnCountingResource : std::pmr::memory_resource
+{
+    size_t allocations{ };
+    size_t deallocations{ };
+
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t align) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+TEST(ColumnHiveTest, AllocatorAndSkipfield)
+{
+    ColumnCountingResource resource;
+    {
+        pmr::column_hive<int, std::string> h{ &resource };
+        for (int i{}; i<40; ++i)
+            h.emplace(i, "row");
+        // blocks of 16 and 32 rows, one allocation each
+        EXPECT_EQ(resource.allocations, 2);
+        EXPECT_EQ(h.get_allocator().resource(), &resource);
+
+        pmr::column_hive<int, std::string> moved{ std::move(h) };
+        EXPECT_EQ(moved.size(), 40);
+    }
+    EXPECT_EQ(resource.deallocations, resource.allocations);
+
+    // uint8 skipfields cap blocks at 255 rows
+    using narrow = basic_column_hive<std::allocator<std::tuple<int, float>>, std::uint8_t, int, float>;
+    static_assert(narrow::MAX_BLOCK_CAPACITY == 255);
+    narrow n;
+    for (int i{}; i<1000; ++i)
+        n.emplace(i, 0.5f);
+    n.erase(n.begin());
+    int sum{ };
+    n.for_each_segment<0>([&sum](std::span<int> keys) { sum = std::accumulate(keys.begin(), keys.end(), sum); });
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+    EXPECT_EQ(n.capacity(), 16 + 32 + 64 + 128 + 255 * 3);
+}
+
+TEST(ColumnHiveTest, MoveAssignAcrossResources)
+{
+    ColumnCountingResource first_resource;
+    ColumnCountingResource second_resource;
+    pmr::column_hive<int, std::string> src{ &first_resource };
+    for (int i{}; i<20; ++i)
+        src.emplace(i, "row");
+
+    // equal resources, the blocks are taken without allocating
+    pmr::column_hive<int, std::string> same{ &first_resource };
+    const int* first_key{ &src.begin().get<0>() };
+    const size_t allocations{ first_resource.allocations };
+    same = std::move(src);
+    EXPECT_EQ(&same.begin().get<0>(), first_key);
+    EXPECT_EQ(first_resource.allocations, allocations);
+    EXPECT_TRUE(src.is_empty());
+
+    // polymorphic allocators do not propagate, rows move into the target's resource
+    pmr::column_hive<int, std::string> other{ &second_resource };
+    other = std::move(same);
+    EXPECT_EQ(other.get_allocator().resource(), &second_resource);
+    EXPECT_EQ(other.size(), 20);
+    EXPECT_GT(second_resource.allocations, 0);
+    EXPECT_TRUE(same.is_empty());
+
+    int sum{ };
+    for (auto it = other.begin(); it != other.end(); ++it)
+        sum += it.get<0>();
+    EXPECT_EQ(sum, 19 * 20 / 2);
+
+    // copies keep the target's resource too
+    pmr::column_hive<int, std::string> copy{ &first_resource };
+    copy = other;
+    EXPECT_EQ(copy.get_allocator().resource(), &first_resource);
+    EXPECT_EQ(copy.size(), 20);
+}
+
+struct CopyBudget
+{
+    static inline int remaining{ };
+
+    CopyBudget() = default;
+    CopyBudget(const CopyBudget&)
+    {
+        if (--remaining < 0)
+            throw std::runtime_error("copy budget spent");
+    }
+};
+
+TEST(ColumnHiveTest, CopyThatThrowsFreesCopiedRows)
+{
+    using budgeted = column_hive<std::string, CopyBudget>;
+    budgeted h;
+    CopyBudget::remaining = 40;
+    for (int i{}; i<40; ++i)
+        h.emplace(std::string(32, 'x'), CopyBudget{ });
+
+    // the rows copied before the throw are destroyed, leak checkers see no leak
+    CopyBudget::remaining = 30;
+    EXPECT_THROW(budgeted{ h }, std::runtime_error);
+}
@@ -0,0 +1,77 @@
+#include "concurrent_hive.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentHiveTest, ShardedEmplace)
+{
+    concurrent_hive<int> h{ 4 };
+    EXPECT_TRUE(h.is_empty());
+
+    constexpr int THREADS{ 4 };
+    constexpr int PER_THREAD{ 5000 };
+    {
+        std::vector<std::jthread> producers;
+        for (int t{}; t<THREADS; ++t)
+        {
+            producers.emplace_back([&h, t]
+            {
+                for (int i{}; i<PER_THREAD; ++i)
+                    h.emplace(t * PER_THREAD + i);
+            });
+        }
+    }
+    EXPECT_EQ(h.size(), THREADS * PER_THREAD);
+
+    std::vector<int> res;
+    h.for_each([&res](int val) { res.push_back(val); });
+    std::ranges::sort(res);
+    for (int i{}; i<THREADS * PER_THREAD; ++i)
+        ASSERT_EQ(res[i], i);
+}
+
+TEST(ConcurrentHiveTest, CrossThreadEraseIsDeferred)
+{
+    concurrent_hive<int> h{ 2 };
+
+    std::vector<concurrent_hive<int>::handle> handles;
+    for (int i{}; i<100; ++i)
+        handles.push_back(h.emplace(i));
+
+    // pointers stay valid while other elements come and go
+    const int* stable = handles[99].get();
+
+    // shards are handed out round robin per thread, so one of the next two threads maps
+    // to the other shard, it finds out through the shard of an element it emplaces
+    bool erased{ false };
+    for (int attempt{}; attempt<2 && !erased; ++attempt)
+    {
+        std::jthread eraser([&h, &handles, &erased]
+        {
+            const auto probe = h.emplace(-1);
+            h.erase(probe);
+            if (probe.shard() == handles[0].shard())
+                return;
+
+            for (int i{}; i<50; ++i)
+                h.erase(handles[i]);
+            erased = true;
+        });
+    }
+    ASSERT_TRUE(erased);
+
+    // the owning shard has not run since, so the erasures are only queued
+    EXPECT_EQ(h.size(), 100);
+    EXPECT_EQ(*handles[0], 0);
+    EXPECT_EQ(*handles[49], 49);
+
+    h.collect();
+    EXPECT_EQ(h.size(), 50);
+    EXPECT_EQ(*stable, 99);
+
+    for (int i{50}; i<100; ++i)
+        h.erase(handles[i]);
+    h.collect();
+    EXPECT_TRUE(h.is_empty());
+}
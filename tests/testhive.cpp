@@ -1,5 +1,17 @@
 #include "hive.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 class HiveTest : public ::testing::Test
@@ -108,4 +120,1125 @@ TEST_F(HiveTest, Clear)
     h.emplace(100);
     EXPECT_EQ(h.size(), 1);
     EXPECT_EQ(*h.begin(), 100);
-}
\ No newline at end of file
+}
+
+TEST_F(HiveTest, EraseReuseChurn)
+{
+    // erasing neighbours coalesces runs, reuse must always take a run head
+    std::vector<int> expected;
+    for (int i{}; i<100; ++i)
+    {
+        h.emplace(i);
+        expected.push_back(i);
+    }
+
+    for (int round{}; round<5; ++round)
+    {
+        for (auto it = h.begin(); it != h.end(); )
+        {
+            if ((*it + round) % 3 != 0)
+            {
+                ++it;
+                continue;
+            }
+            std::erase(expected, *it);
+            it = h.erase(it);
+        }
+
+        for (int i{}; i<20; ++i)
+        {
+            h.emplace(1000*(round+1) + i);
+            expected.push_back(1000*(round+1) + i);
+        }
+    }
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+    std::ranges::sort(res);
+    std::ranges::sort(expected);
+    EXPECT_EQ(res, expected);
+    EXPECT_EQ(h.size(), expected.size());
+}
+
+TEST(HiveSkipfieldTest, NarrowSkipfieldCapsBlocks)
+{
+    hive<int, std::allocator<int>, std::uint8_t> small;
+    for (int i{}; i<2000; ++i)
+        small.emplace(i);
+
+    // 4+8+...+128 then blocks of 255
+    EXPECT_EQ(small.capacity(), 252 + 255*7);
+
+    int expected_val{};
+    for (auto it = small.begin(); it != small.end(); )
+    {
+        EXPECT_EQ(*it, expected_val++);
+        it = (*it % 2 == 0) ? small.erase(it) : ++it;
+    }
+    EXPECT_EQ(small.size(), 1000);
+
+    expected_val = 1;
+    for (const auto& val : small)
+    {
+        EXPECT_EQ(val, expected_val);
+        expected_val += 2;
+    }
+}
+
+TEST_F(HiveTest, BeginTracksFirstActive)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<50; ++i)
+        its.push_back(h.emplace(i));
+
+    // erase the front, begin follows the next active element across blocks
+    for (int i{}; i<30; ++i)
+    {
+        h.erase(its[i]);
+        ASSERT_EQ(*h.begin(), i+1);
+    }
+
+    // reusing a slot ahead of the current begin moves begin back
+    auto reused = h.emplace(-1);
+    EXPECT_EQ(h.begin(), reused);
+    EXPECT_EQ(*h.begin(), -1);
+
+    const hive<int>& const_h = h;
+    EXPECT_EQ(const_h.begin(), h.begin());
+
+    for (auto it = h.begin(); it != h.end(); )
+        it = h.erase(it);
+    EXPECT_EQ(h.begin(), h.end());
+
+    h.emplace(7);
+    EXPECT_EQ(*h.begin(), 7);
+}
+
+TEST_F(HiveTest, ReuseFillsLowestBlockFirst)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<28; ++i)
+        its.push_back(h.emplace(i));
+
+    // holes in the third block (12..27) are made before holes in the first (0..3)
+    h.erase(its[20]);
+    h.erase(its[21]);
+    h.erase(its[1]);
+    h.erase(its[2]);
+
+    auto first  = h.emplace(100);
+    auto second = h.emplace(101);
+    auto third  = h.emplace(102);
+    EXPECT_EQ(h.capacity(), 28);
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+
+    std::vector<int> expected{0, 100, 101, 3};
+    for (int i{4}; i<28; ++i)
+    {
+        if (i == 20) expected.push_back(102);
+        else if (i != 21) expected.push_back(i);
+    }
+    EXPECT_EQ(res, expected);
+    EXPECT_EQ(*first, 100);
+    EXPECT_EQ(*second, 101);
+    EXPECT_EQ(*third, 102);
+}
+
+TEST_F(HiveTest, EmptyBlocksReleased)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<28; ++i)
+        its.push_back(h.emplace(i));
+    EXPECT_EQ(h.capacity(), 4+8+16);
+
+    // emptying the second block unlinks it, one spare is kept by default
+    for (int i{4}; i<12; ++i)
+        h.erase(its[i]);
+    EXPECT_EQ(h.capacity(), 4+8+16);
+
+    // emptying the first block as well frees it since the spare slot is taken
+    for (int i{}; i<4; ++i)
+        h.erase(its[i]);
+    EXPECT_EQ(h.capacity(), 8+16);
+    EXPECT_EQ(*h.begin(), 12);
+
+    // erased slots of released blocks are not reused, the spare is
+    for (int i{}; i<8; ++i)
+        h.emplace(100+i);
+    EXPECT_EQ(h.capacity(), 8+16);
+    EXPECT_EQ(h.size(), 24);
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+    EXPECT_EQ(res.size(), 24);
+    EXPECT_EQ(res.front(), 12);
+    EXPECT_EQ(res.back(), 107);
+}
+
+TEST_F(HiveTest, TrimCapacity)
+{
+    h.set_spare_block_limit(8);
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<60; ++i)
+        its.push_back(h.emplace(i));
+    EXPECT_EQ(h.capacity(), 4+8+16+32);
+
+    for (int i{}; i<28; ++i)
+        h.erase(its[i]);
+    EXPECT_EQ(h.capacity(), 4+8+16+32);
+
+    // spares are freed most recently released first: 16, then 8 would drop below 40
+    h.trim_capacity(40);
+    EXPECT_EQ(h.capacity(), 4+8+32);
+
+    h.shrink_to_fit();
+    EXPECT_EQ(h.capacity(), 32);
+    EXPECT_EQ(h.size(), 32);
+
+    h.set_spare_block_limit(0);
+    for (int i{28}; i<60; ++i)
+        h.erase(its[i]);
+    EXPECT_EQ(h.capacity(), 0);
+    EXPECT_EQ(h.begin(), h.end());
+
+    h.emplace(1);
+    EXPECT_EQ(*h.begin(), 1);
+}
+
+TEST_F(HiveTest, Reserve)
+{
+    h.reserve(100);
+    EXPECT_EQ(h.capacity(), 100);
+    EXPECT_TRUE(h.is_empty());
+    EXPECT_EQ(h.begin(), h.end());
+
+    for (int i{}; i<100; ++i)
+        h.emplace(i);
+    EXPECT_EQ(h.capacity(), 100);
+
+    int expected_val{};
+    for (const auto& val : h)
+        EXPECT_EQ(val, expected_val++);
+    EXPECT_EQ(expected_val, 100);
+
+    h.reserve(50);
+    EXPECT_EQ(h.capacity(), 100);
+}
+
+TEST(HiveLimitsTest, BlockCapacityLimits)
+{
+    hive<int> limited{ hive_limits{ 16, 64 } };
+    EXPECT_EQ(limited.block_capacity_limits().min, 16);
+    EXPECT_EQ(limited.block_capacity_limits().max, 64);
+
+    for (int i{}; i<16+32+64+64; ++i)
+        limited.emplace(i);
+    EXPECT_EQ(limited.capacity(), 16+32+64+64);
+
+    limited.set_growth_factor(1.0);
+    limited.set_block_capacity_limits(hive_limits{ 8, 8 });
+    limited.emplace(0);
+    limited.emplace(0);
+    EXPECT_EQ(limited.capacity(), 16+32+64+64+8);
+
+    // reserve splits into blocks no larger than the maximum
+    limited.reserve(limited.capacity() + 20);
+    EXPECT_EQ(limited.capacity(), 16+32+64+64+8+24);
+
+    EXPECT_THROW(limited.set_block_capacity_limits(hive_limits{ 8, 4 }), std::length_error);
+    EXPECT_THROW(limited.set_block_capacity_limits(hive_limits{ 0, 4 }), std::length_error);
+    EXPECT_THROW((hive<int, std::allocator<int>, std::uint8_t>{ hive_limits{ 4, 1000 } }), std::length_error);
+    EXPECT_THROW(limited.set_growth_factor(0.5), std::invalid_argument);
+
+    // a huge factor saturates at the maximum instead of overflowing the capacity
+    limited.set_block_capacity_limits(hive_limits{ 8, 64 });
+    limited.set_growth_factor(1e300);
+    limited.insert(limited.capacity() - limited.size() + 1, 0);
+    limited.insert(65, 0);
+    const hive_stats grown{ limited.stats() };
+    EXPECT_EQ(grown.blocks.back().capacity, 64);
+
+    // the whole block, header included, fits the byte budget and one more slot would not
+    struct LargestAllocation : std::pmr::memory_resource
+    {
+        size_t largest{ };
+
+        void* do_allocate(size_t bytes, size_t align) override
+        {
+            largest = std::max(largest, bytes);
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t align) override { std::pmr::new_delete_resource()->deallocate(p, bytes, align); }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+    const auto block_bytes = []<typename H>(std::type_identity<H>, size_t capacity)
+    {
+        LargestAllocation resource;
+        H one_block{ hive_limits{ capacity, capacity }, &resource };
+        one_block.emplace();
+        return resource.largest;
+    };
+    const auto fits = [&]<typename H>(std::type_identity<H> type, size_t bytes)
+    {
+        const size_t fitted{ H::block_capacity_for_bytes(bytes) };
+        return block_bytes(type, fitted) <= bytes && block_bytes(type, fitted + 1) > bytes;
+    };
+    using pmr_int = std::pmr::polymorphic_allocator<int>;
+    using pmr_array = std::pmr::polymorphic_allocator<std::array<double, 5>>;
+    EXPECT_TRUE(fits(std::type_identity<hive<int, pmr_int>>{ }, 4096));
+    EXPECT_TRUE(fits(std::type_identity<hive<int, pmr_int, std::uint16_t, true>>{ }, 4096));
+    EXPECT_TRUE(fits(std::type_identity<hive<std::array<double, 5>, pmr_array>>{ }, 1 << 16));
+    EXPECT_LT(hive<int>::block_capacity_for_bytes(4096), 4096 / 6);
+    EXPECT_EQ(hive<int>::block_capacity_for_bytes(8), 1);
+}
+
+TEST_F(HiveTest, BulkInsert)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<12; ++i)
+        its.push_back(h.emplace(i));
+
+    // two erased runs in the second block get filled before new blocks
+    h.erase(its[5]);
+    h.erase(its[6]);
+    h.erase(its[9]);
+
+    std::vector<int> src(40);
+    std::iota(src.begin(), src.end(), 100);
+    h.insert(src.begin(), src.end());
+    EXPECT_EQ(h.size(), 49);
+    EXPECT_EQ(h.capacity(), 4+8+37);
+
+    h.insert(3, -1);
+    h.insert({ 7, 8 });
+    EXPECT_EQ(h.size(), 54);
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+
+    // runs within a block are reused most recently erased first
+    std::vector<int> expected{0, 1, 2, 3, 4, 101, 102, 7, 8, 100, 10, 11};
+    for (int i{103}; i<140; ++i)
+        expected.push_back(i);
+    expected.insert(expected.end(), { -1, -1, -1, 7, 8 });
+    EXPECT_EQ(res, expected);
+}
+
+TEST_F(HiveTest, InsertRange)
+{
+    h.insert_range(std::views::iota(0, 10) | std::views::filter([](int i) { return i % 2 == 0; }));
+    h.insert_range(std::vector<int>{ 10, 11 });
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+    EXPECT_EQ(res, (std::vector<int>{ 0, 2, 4, 6, 8, 10, 11 }));
+
+    // copies of a non trivial type through the generic path
+    hive<std::string> strings;
+    std::vector<std::string> words{ "a", "bb", "ccc" };
+    strings.insert(words.begin(), words.end());
+    strings.insert(2, std::string(40, 'x'));
+    EXPECT_EQ(strings.size(), 5);
+    EXPECT_EQ(*strings.begin(), "a");
+}
+
+TEST_F(HiveTest, RangeErase)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<60; ++i)
+        its.push_back(h.emplace(i));
+    h.erase(its[20]);
+
+    // spans the end of the third block and all of the fourth but one
+    auto result = h.erase(its[10], its[59]);
+    EXPECT_EQ(result, its[59]);
+    EXPECT_EQ(h.size(), 11);
+    EXPECT_EQ(h.capacity(), 4+8+16+32);
+
+    h.erase(h.begin(), its[2]);
+    EXPECT_EQ(*h.begin(), 2);
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+    EXPECT_EQ(res, (std::vector<int>{ 2, 3, 4, 5, 6, 7, 8, 9, 59 }));
+
+    auto after = h.erase(h.begin(), h.end());
+    EXPECT_EQ(after, h.end());
+    EXPECT_TRUE(h.is_empty());
+    EXPECT_EQ(h.begin(), h.end());
+}
+
+TEST_F(HiveTest, EraseIf)
+{
+    for (int i{}; i<200; ++i)
+        h.emplace(i);
+
+    EXPECT_EQ(erase_if(h, [](int val) { return val % 3 != 0; }), 133);
+    EXPECT_EQ(h.size(), 67);
+    EXPECT_EQ(erase_if(h, [](int val) { return val < 100; }), 34);
+    EXPECT_EQ(erase(h, 102), 1);
+    EXPECT_EQ(*h.begin(), 105);
+
+    int expected_val{ 105 };
+    for (const auto& val : h)
+    {
+        EXPECT_EQ(val, expected_val);
+        expected_val += 3;
+    }
+    EXPECT_EQ(expected_val, 201);
+
+    // holes left by the sweep are reused
+    const size_t capacity = h.capacity();
+    for (int i{}; i<50; ++i)
+        h.emplace(-i);
+    EXPECT_EQ(h.capacity(), capacity);
+    EXPECT_EQ(erase_if(h, [](int val) { return val <= 0; }), 50);
+    EXPECT_EQ(h.size(), 32);
+}
+
+TEST_F(HiveTest, ParallelTraversal)
+{
+    constexpr int COUNT{ 100'000 };
+    for (int i{}; i<COUNT; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 4 == 0; });
+
+    long long expected{ };
+    for (const auto& val : h)
+        expected += val;
+
+    EXPECT_EQ(h.parallel_reduce(0LL, std::plus<>{}, 4), expected);
+    EXPECT_EQ(h.parallel_transform_reduce(0LL, std::plus<>{}, [](int val) { return 2LL * val; }, 4), 2 * expected);
+
+    h.parallel_for_each([](int& val) { val += 1; }, 4);
+    h.parallel_transform([](int val) { return val * 2; }, 3);
+    EXPECT_EQ(h.parallel_reduce(0LL, std::plus<>{}), 2 * (expected + static_cast<long long>(h.size())));
+
+    std::atomic<size_t> visited{ };
+    const hive<int>& const_h = h;
+    const_h.parallel_for_each([&visited](const int&) { visited.fetch_add(1, std::memory_order_relaxed); }, 8);
+    EXPECT_EQ(visited.load(), h.size());
+
+    EXPECT_THROW(h.parallel_for_each([](int& val) { if (val == 4) throw std::runtime_error("boom"); }, 4), std::runtime_error);
+
+    hive<int> empty;
+    EXPECT_EQ(empty.parallel_reduce(7), 7);
+
+    // caller owned pools keep their workers across calls, a pool without workers runs inline
+    hive_thread_pool pool{ 3 };
+    hive_thread_pool inline_pool{ 0 };
+    for (int tick{}; tick<200; ++tick)
+    {
+        h.parallel_for_each([](int& val) { val += 1; }, 0, pool);
+        h.parallel_for_each([](int& val) { val -= 1; }, 4, inline_pool);
+    }
+    EXPECT_EQ(h.parallel_reduce(0LL, std::plus<>{}, 0, pool), 2 * (expected + static_cast<long long>(h.size())));
+    EXPECT_EQ(pool.worker_count(), 3);
+}
+
+TEST_F(HiveTest, BidirectionalIterator)
+{
+    static_assert(std::bidirectional_iterator<hive<int>::iterator>);
+    static_assert(std::bidirectional_iterator<hive<int>::const_iterator>);
+
+    for (int i{}; i<100; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 5 == 0 || (val > 20 && val < 40); });
+
+    std::vector<int> forward;
+    for (const auto& val : h)
+        forward.push_back(val);
+
+    std::vector<int> backward;
+    for (auto it = h.rbegin(); it != h.rend(); ++it)
+        backward.push_back(*it);
+    std::ranges::reverse(backward);
+    EXPECT_EQ(forward, backward);
+
+    auto it = h.end();
+    --it;
+    EXPECT_EQ(*it, 99);
+    it--;
+    EXPECT_EQ(*it, 98);
+    EXPECT_EQ(*--h.end(), 99);
+    EXPECT_EQ(*std::prev(h.end()), 99);
+}
+
+TEST_F(HiveTest, AdvanceAndDistance)
+{
+    for (int i{}; i<500; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 3 == 0 || (val > 100 && val < 200); });
+
+    std::vector<int> values;
+    for (const auto& val : h)
+        values.push_back(val);
+    const auto count = static_cast<std::ptrdiff_t>(values.size());
+
+    EXPECT_EQ(distance(h.begin(), h.end()), count);
+    EXPECT_EQ(distance(h.end(), h.begin()), -count);
+
+    for (std::ptrdiff_t from{}; from<count; from += 7)
+    {
+        for (std::ptrdiff_t n{}; from+n<=count; n += 13)
+        {
+            auto it = h.begin();
+            advance(it, from);
+            ASSERT_EQ(*it, values[from]);
+
+            auto jumped = next(it, n);
+            if (from+n == count)
+                ASSERT_EQ(jumped, h.end());
+            else
+                ASSERT_EQ(*jumped, values[from+n]);
+            ASSERT_EQ(distance(it, jumped), n);
+            ASSERT_EQ(prev(jumped, n), it);
+        }
+    }
+
+    auto it = h.end();
+    advance(it, -count);
+    EXPECT_EQ(it, h.begin());
+}
+
+TEST_F(HiveTest, Splice)
+{
+    for (int i{}; i<10; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 2 == 1; });
+
+    hive<int> other;
+    std::vector<hive<int>::iterator> its;
+    for (int i{100}; i<120; ++i)
+        its.push_back(other.emplace(i));
+    other.erase(its[3]);
+    const int* stable = &*its[10];
+
+    h.splice(other);
+    EXPECT_TRUE(other.is_empty());
+    EXPECT_EQ(other.capacity(), 0);
+    EXPECT_EQ(other.begin(), other.end());
+    EXPECT_EQ(h.size(), 5+19);
+    EXPECT_EQ(h.capacity(), 4+8+4+8+16);
+
+    // elements were not moved, iterators into them still work
+    EXPECT_EQ(&*its[10], stable);
+    EXPECT_EQ(*its[10], 110);
+    EXPECT_EQ(distance(h.begin(), its[10]), 5+9);
+
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val);
+    std::vector<int> expected{ 0, 2, 4, 6, 8 };
+    for (int i{100}; i<120; ++i)
+        if (i != 103) expected.push_back(i);
+    EXPECT_EQ(res, expected);
+
+    // free slots of both hives are still reused, ours first
+    h.emplace(-1);
+    h.emplace(-2);
+    EXPECT_EQ(h.capacity(), 4+8+4+8+16);
+
+    // the source stays usable
+    other.emplace(5);
+    EXPECT_EQ(*other.begin(), 5);
+
+    hive<int> empty;
+    empty.splice(h);
+    EXPECT_EQ(empty.size(), 26);
+    EXPECT_TRUE(h.is_empty());
+
+    hive<int> limited{ hive_limits{ 64, 128 } };
+    EXPECT_THROW(limited.splice(empty), std::length_error);
+}
+
+TEST(HiveHandleTest, GenerationalHandles)
+{
+    using gen_hive = hive<int, std::allocator<int>, std::uint16_t, true>;
+    static_assert(sizeof(gen_hive::compact_handle) == 4);
+    static_assert(sizeof(gen_hive::handle) == 8);
+
+    gen_hive h;
+    std::vector<gen_hive::handle> handles;
+    for (int i{}; i<20; ++i)
+        handles.push_back(h.get_handle(h.emplace(i)));
+    for (int i{}; i<20; ++i)
+        EXPECT_EQ(*h.get(handles[i]), i);
+
+    EXPECT_EQ(h.get(gen_hive::handle{}), nullptr);
+    EXPECT_TRUE(gen_hive::handle{}.is_null());
+
+    // erasing makes the handle stale, reusing the slot does not revive it
+    auto itr = h.begin();
+    advance(itr, 5);
+    auto compact = h.get_handle<std::uint32_t>(itr);
+    h.erase(itr);
+    EXPECT_EQ(h.get(handles[5]), nullptr);
+    EXPECT_EQ(h.get(compact), nullptr);
+
+    auto reused = h.emplace(99);
+    EXPECT_EQ(reused.operator->(), &*h.get(handles[4]) + 1);
+    EXPECT_EQ(h.get(handles[5]), nullptr);
+    EXPECT_EQ(*h.get(h.get_handle(reused)), 99);
+
+    // a freed block's index is reused with generations above any it handed out
+    gen_hive::handle first_block = handles[0];
+    h.set_spare_block_limit(0);
+    h.erase(h.begin(), std::next(h.begin(), 4));
+    EXPECT_EQ(h.get(first_block), nullptr);
+    h.reserve(200);
+    for (int i{}; i<200; ++i)
+        h.emplace(i);
+    EXPECT_EQ(h.get(first_block), nullptr);
+    EXPECT_EQ(*h.get(handles[19]), 19);
+
+    // spliced elements keep working through new handles, old ones go stale
+    gen_hive other;
+    auto moved = other.emplace(7);
+    auto old_handle = other.get_handle(moved);
+    h.splice(other);
+    EXPECT_EQ(other.get(old_handle), nullptr);
+    EXPECT_EQ(*h.get(h.get_handle(moved)), 7);
+
+    h.clear();
+    EXPECT_EQ(h.get(handles[19]), nullptr);
+}
+
+// Allocator that counts destroy calls, so trivial fast paths must still call it
+template<typename T>
+struct DestroyCountingAllocator : std::allocator<T>
+{
+    using value_type = T;
+    template<typename U> struct rebind { using other = DestroyCountingAllocator<U>; };
+
+    inline static int destroyed{ };
+
+    DestroyCountingAllocator() = default;
+    template<typename U>
+    DestroyCountingAllocator(const DestroyCountingAllocator<U>&) noexcept { }
+
+    template<typename U>
+    void destroy(U* p) { ++destroyed; p->~U(); }
+};
+
+TEST(HiveTrivialTest, ClearAndDestroy)
+{
+    hive<int> h;
+    h.insert(1000, 7);
+    auto itr = h.begin();
+    for (int i{}; i<500; ++i)
+        itr = h.erase(itr);
+    EXPECT_EQ(std::accumulate(h.begin(), h.end(), 0), 500 * 7);
+    h.clear();
+    EXPECT_TRUE(h.is_empty());
+    EXPECT_EQ(h.capacity(), 0);
+
+    // an allocator with its own destroy is still called for trivial types
+    {
+        hive<int, DestroyCountingAllocator<int>> counted;
+        counted.insert(10, 1);
+        counted.erase(counted.begin());
+        EXPECT_EQ(DestroyCountingAllocator<int>::destroyed, 1);
+        counted.clear();
+        EXPECT_EQ(DestroyCountingAllocator<int>::destroyed, 10);
+    }
+
+    // non trivial elements are still destroyed
+    hive<std::string> strings;
+    strings.insert(100, std::string(64, 'x'));
+    strings.erase(strings.begin(), std::next(strings.begin(), 50));
+    strings.clear();
+    EXPECT_TRUE(strings.is_empty());
+}
+
+TEST_F(HiveTest, CopyAndMove)
+{
+    static_assert(std::is_nothrow_move_constructible_v<hive<int>>);
+    static_assert(std::is_nothrow_move_assignable_v<hive<int>>);
+
+    for (int i{}; i<1000; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 3 != 0; });
+
+    // the copy packs the 334 survivors into one block
+    hive<int> copy{ h };
+    EXPECT_EQ(copy.size(), h.size());
+    EXPECT_EQ(copy.capacity(), copy.size());
+    EXPECT_TRUE(std::ranges::equal(copy, h));
+
+    hive<int> moved{ std::move(copy) };
+    EXPECT_TRUE(copy.is_empty());
+    EXPECT_EQ(copy.capacity(), 0);
+    EXPECT_TRUE(std::ranges::equal(moved, h));
+    copy.emplace(1);
+    EXPECT_EQ(copy.size(), 1);
+
+    const int* stable = &*moved.begin();
+    hive<int> assigned;
+    assigned.emplace(-1);
+    assigned = std::move(moved);
+    EXPECT_EQ(&*assigned.begin(), stable);
+    EXPECT_TRUE(moved.is_empty());
+
+    assigned = copy;
+    EXPECT_EQ(assigned.size(), 1);
+    EXPECT_EQ(*assigned.begin(), 1);
+
+    // block limits carry over and cap the packed blocks
+    hive<std::string> strings{ hive_limits{ 8, 16 } };
+    for (int i{}; i<100; ++i)
+        strings.emplace(std::to_string(i));
+    strings.erase(strings.begin(), std::next(strings.begin(), 60));
+    hive<std::string> string_copy{ strings };
+    EXPECT_EQ(string_copy.capacity(), 48);
+    EXPECT_EQ(string_copy.block_capacity_limits().max, 16);
+    EXPECT_TRUE(std::ranges::equal(string_copy, strings));
+
+    std::vector<hive<int>> hives;
+    hives.push_back(h);
+    hives.emplace_back();
+    EXPECT_EQ(hives[0].size(), 334);
+}
+
+// writes its first member before the second one's constructor can throw, so a failed
+// emplace has already overwritten the free list links kept in the reused slot
+struct ThrowsMidConstruct
+{
+    struct Fuse
+    {
+        static inline bool armed{ false };
+        Fuse() { if (armed) throw std::runtime_error("fuse"); }
+    };
+
+    std::uint64_t value;
+    Fuse fuse;
+
+    explicit ThrowsMidConstruct(std::uint64_t v)
+        : value(v)
+    { }
+};
+
+TEST(HiveExceptionTest, EmplaceThrowsIntoReusedSlot)
+{
+    hive<ThrowsMidConstruct> h;
+    std::vector<hive<ThrowsMidConstruct>::iterator> its;
+    for (std::uint64_t i{}; i<12; ++i)
+        its.push_back(h.emplace(i));
+    h.erase(its[1]);
+    h.erase(its[5]);
+    h.erase(its[6]);
+
+    ThrowsMidConstruct::Fuse::armed = true;
+    EXPECT_THROW(h.emplace(std::uint64_t{ 0x7fff'7fff'7fff'7fff }), std::runtime_error);
+    ThrowsMidConstruct::Fuse::armed = false;
+    EXPECT_EQ(h.size(), 9);
+
+    // the erased slots are still all free and reused as before
+    for (std::uint64_t i{100}; i<104; ++i)
+        h.emplace(i);
+    EXPECT_EQ(h.size(), 13);
+    EXPECT_EQ(h.capacity(), 4+8+16);
+
+    std::vector<std::uint64_t> res;
+    for (const auto& val : h)
+        res.push_back(val.value);
+    EXPECT_EQ(res, (std::vector<std::uint64_t>{ 0, 100, 2, 3, 4, 101, 102, 7, 8, 9, 10, 11, 103 }));
+}
+
+TEST_F(HiveTest, Compact)
+{
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<1000; ++i)
+        its.push_back(h.emplace(i));
+    for (size_t i{}; i<its.size(); ++i)
+        if (i % 10 != 0)
+            h.erase(its[i]);
+    const size_t capacity_before{ h.capacity() };
+
+    // external pointers, fixed up through the relocation callback
+    std::vector<const int*> refs;
+    for (const int& val : h)
+        refs.push_back(&val);
+    size_t relocations{ };
+    h.compact([&](int* old_ptr, int* new_ptr)
+    {
+        EXPECT_EQ(*old_ptr, *new_ptr);
+        const auto ref = std::ranges::find(refs, old_ptr);
+        ASSERT_NE(ref, refs.end());
+        *ref = new_ptr;
+        ++relocations;
+    });
+
+    EXPECT_GT(relocations, 0);
+    EXPECT_EQ(h.size(), 100);
+    EXPECT_LT(h.capacity(), capacity_before);
+
+    // every value survived and the fixed up pointers still find them
+    std::vector<int> res(h.begin(), h.end());
+    std::ranges::sort(res);
+    for (int i{}; i<100; ++i)
+    {
+        EXPECT_EQ(res[static_cast<size_t>(i)], i * 10);
+        EXPECT_EQ(*refs[static_cast<size_t>(i)], i * 10);
+    }
+    EXPECT_TRUE(h.compact_step(1));
+}
+
+TEST_F(HiveTest, CompactIncremental)
+{
+    for (int i{}; i<500; ++i)
+        h.emplace(i);
+    erase_if(h, [](int val) { return val % 2 == 0; });
+
+    int steps{ };
+    while (!h.compact_step(8))
+        ++steps;
+    EXPECT_GT(steps, 1);
+    EXPECT_EQ(h.size(), 250);
+    EXPECT_EQ(std::accumulate(h.begin(), h.end(), 0), 250 * 250);
+
+    // a hive with holes only in its last block has nothing to compact
+    hive<int> single;
+    single.insert(4, 1);
+    single.erase(single.begin());
+    EXPECT_TRUE(single.compact_step(10));
+    EXPECT_TRUE(hive<int>{}.compact_step(10));
+}
+
+struct ThrowingMove
+{
+    static inline int moves_left{ -1 };
+    int value;
+
+    explicit ThrowingMove(int v)
+        : value(v)
+    { }
+
+    ThrowingMove(ThrowingMove&& other)
+        : value(other.value)
+    {
+        if (moves_left >= 0 && moves_left-- == 0)
+            throw std::runtime_error("move");
+    }
+};
+
+TEST(HiveExceptionTest, CompactMoveThrows)
+{
+    hive<ThrowingMove> h;
+    std::vector<hive<ThrowingMove>::iterator> its;
+    for (int i{}; i<60; ++i)
+        its.push_back(h.emplace(i));
+    for (size_t i{}; i<its.size(); ++i)
+        if (i % 3 != 0)
+            h.erase(its[i]);
+
+    ThrowingMove::moves_left = 5;
+    EXPECT_THROW(h.compact(), std::runtime_error);
+    ThrowingMove::moves_left = -1;
+
+    // 5 elements moved, the one that threw is still in place and nothing was lost
+    EXPECT_EQ(h.size(), 20);
+    std::vector<int> res;
+    for (const auto& val : h)
+        res.push_back(val.value);
+    std::ranges::sort(res);
+    for (int i{}; i<20; ++i)
+        EXPECT_EQ(res[static_cast<size_t>(i)], i * 3);
+
+    // the hive keeps working, compaction can resume and emplace reuses what is left
+    h.compact();
+    h.emplace(-1);
+    EXPECT_EQ(h.size(), 21);
+    EXPECT_EQ(std::ranges::count_if(h, [](const ThrowingMove& val) { return val.value % 3 == 0; }), 20);
+}
+
+TEST_F(HiveTest, Stats)
+{
+    hive_stats empty{ h.stats() };
+    EXPECT_EQ(empty.block_count, 0);
+    EXPECT_EQ(empty.bytes_allocated, 0);
+
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<12; ++i)
+        its.push_back(h.emplace(i));
+    // block 0 holds 0..3, block 1 holds 4..11
+    h.erase(its[1]);
+    h.erase(its[5]);
+    h.erase(its[6]);
+    h.erase(its[7]);
+    h.erase(its[9]);
+
+    const hive_stats stats{ h.stats() };
+    EXPECT_EQ(stats.size, 7);
+    EXPECT_EQ(stats.capacity, 12);
+    EXPECT_EQ(stats.block_count, 2);
+    ASSERT_EQ(stats.blocks.size(), 2);
+    EXPECT_EQ(stats.blocks[0].capacity, 4);
+    EXPECT_EQ(stats.blocks[0].active, 3);
+    EXPECT_EQ(stats.blocks[1].active, 4);
+    EXPECT_EQ(stats.blocks[1].erased_runs, 2);
+
+    // runs of length 1, 3 and 1
+    std::vector<size_t> histogram{ 2, 1 };
+    EXPECT_EQ(stats.erased_run_histogram, histogram);
+    EXPECT_EQ(stats.erased_slots, 5);
+    EXPECT_EQ(stats.free_list_length, 3);
+    EXPECT_EQ(stats.blocks_with_free, 2);
+    EXPECT_GE(stats.bytes_allocated, 12 * (sizeof(int) + sizeof(std::uint16_t)));
+
+    const hive_counters counters{ h.counters() };
+    if constexpr (hive_counters_enabled)
+    {
+        EXPECT_EQ(counters.emplaced, 12);
+        EXPECT_EQ(counters.erased, 5);
+        EXPECT_EQ(counters.blocks_allocated, 2);
+    }
+    else
+    {
+        EXPECT_EQ(counters.emplaced, 0);
+    }
+}
+
+// Memory resource that counts its calls, to check where blocks come from
+struct CountingResource : std::pmr::memory_resource
+{
+    size_t allocations{ };
+    size_t deallocations{ };
+    std::pmr::memory_resource* upstream{ std::pmr::new_delete_resource() };
+
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+        ++allocations;
+        return upstream->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t align) override
+    {
+        ++deallocations;
+        upstream->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+TEST(HivePmrTest, OneAllocationPerBlock)
+{
+    CountingResource resource;
+    {
+        pmr::hive<int> h{ &resource };
+        for (int i{}; i<12; ++i)
+            h.emplace(i);
+        EXPECT_EQ(resource.allocations, 2);
+        EXPECT_EQ(h.get_allocator().resource(), &resource);
+
+        // copies take the default resource, copy assignment keeps the target's
+        pmr::hive<int> copy{ h };
+        EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+        pmr::hive<int> assigned{ &resource };
+        assigned = copy;
+        EXPECT_EQ(assigned.get_allocator().resource(), &resource);
+        EXPECT_TRUE(std::ranges::equal(assigned, h));
+
+        // moving between resources moves elements instead of stealing blocks
+        assigned = std::move(copy);
+        EXPECT_EQ(assigned.get_allocator().resource(), &resource);
+        EXPECT_EQ(assigned.size(), 12);
+        EXPECT_TRUE(copy.is_empty());
+    }
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
+TEST(HivePmrTest, ArenaDrop)
+{
+    CountingResource upstream;
+    std::pmr::monotonic_buffer_resource arena{ &upstream };
+    CountingResource counted;
+    counted.upstream = &arena;
+
+    // only polymorphic allocators hand the blocks back to a resource
+    constexpr auto droppable = []<typename H>(std::type_identity<H>) { return requires (H& other) { other.drop(); }; };
+    static_assert(droppable(std::type_identity<pmr::hive<int>>{ }));
+    static_assert(!droppable(std::type_identity<hive<int>>{ }));
+
+    pmr::hive<int> h{ &counted };
+    h.insert(1000, 3);
+    h.erase(h.begin(), std::next(h.begin(), 10));
+    const size_t allocations{ counted.allocations };
+
+    h.drop();
+    EXPECT_TRUE(h.is_empty());
+    EXPECT_EQ(h.capacity(), 0);
+    EXPECT_EQ(counted.deallocations, 0);
+
+    // the hive stays usable on the same arena
+    h.emplace(5);
+    EXPECT_EQ(*h.begin(), 5);
+    EXPECT_EQ(counted.allocations, allocations + 1);
+    h.drop();
+}
+
+TEST_F(HiveTest, Segments)
+{
+    static_assert(std::same_as<hive<int>::segment, std::span<int>>);
+    static_assert(std::ranges::forward_range<decltype(h.segments())>);
+    EXPECT_EQ(std::ranges::distance(h.segments()), 0);
+
+    std::vector<hive<int>::iterator> its;
+    for (int i{}; i<12; ++i)
+        its.push_back(h.emplace(i));
+    // block 0 holds 0..3, block 1 holds 4..11
+    h.erase(its[1]);
+    h.erase(its[6]);
+    h.erase(its[7]);
+
+    // runs this short are cheaper to visit element by element
+    std::vector<std::vector<int>> runs;
+    for (std::span<int> seg : h.segments())
+        runs.emplace_back(seg.begin(), seg.end());
+    std::vector<std::vector<int>> expected{ { 0 }, { 2 }, { 3 }, { 4 }, { 5 }, { 8 }, { 9 }, { 10 }, { 11 } };
+    EXPECT_EQ(runs, expected);
+
+    // long runs are whole segments, blocks of 4, 8, 16 and 32 hold 0..59
+    hive<int> dense;
+    std::vector<hive<int>::iterator> dense_its;
+    for (int i{}; i<60; ++i)
+        dense_its.push_back(dense.emplace(i));
+    dense.erase(dense_its[40]);
+    std::vector<size_t> lengths;
+    for (std::span<int> seg : dense.segments())
+        lengths.push_back(seg.size());
+    EXPECT_EQ(lengths, (std::vector<size_t>{ 4, 8, 16, 12, 19 }));
+
+    h.for_each_segment([](std::span<int> seg)
+    {
+        for (int& val : seg)
+            val *= 2;
+    });
+    const hive<int>& const_h = h;
+    int sum{ };
+    const_h.for_each_segment([&sum](std::span<const int> seg) { sum = std::accumulate(seg.begin(), seg.end(), sum); });
+    EXPECT_EQ(sum, 2 * (0+2+3+4+5+8+9+10+11));
+
+    // chars are narrower than the free list links, segments are strided views then
+    hive<char> chars;
+    static_assert(!hive<char>::CONTIGUOUS_SEGMENTS);
+    const std::string letters{ "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ" };
+    for (char c : letters)
+        chars.emplace(c);
+    chars.erase(std::next(chars.begin(), 30));
+    std::string joined;
+    for (auto seg : chars.segments())
+        for (char c : seg)
+            joined += c;
+    EXPECT_EQ(joined, letters.substr(0, 30) + letters.substr(31));
+    // the fourth block starts with 'C' and 'D', then 'E' is erased
+    EXPECT_EQ((*std::next(chars.segments().begin(), 3)).size(), 2);
+}
+
+TEST(HiveSmallTest, InlineFirstBlock)
+{
+    using small = small_hive<int, 8, std::pmr::polymorphic_allocator<int>>;
+    CountingResource resource;
+    {
+        small h{ &resource };
+        for (int i{}; i<8; ++i)
+            h.emplace(i);
+        EXPECT_EQ(resource.allocations, 0);
+        EXPECT_EQ(h.capacity(), 8);
+        EXPECT_EQ(h.stats().bytes_allocated, 0);
+
+        // the ninth element spills into a heap block
+        h.emplace(8);
+        EXPECT_EQ(resource.allocations, 1);
+        EXPECT_EQ(h.size(), 9);
+
+        // moves carry the elements over, the source's embedded block stays behind
+        small moved{ std::move(h) };
+        EXPECT_TRUE(h.is_empty());
+        EXPECT_EQ(moved.size(), 9);
+        EXPECT_TRUE(std::ranges::equal(moved, std::views::iota(0, 9)));
+
+        small copy{ moved };
+        copy.erase(copy.begin());
+        copy.swap(moved);
+        EXPECT_EQ(copy.size(), 9);
+        EXPECT_EQ(moved.size(), 8);
+
+        // clearing frees the heap block, the embedded block is reused without allocating
+        moved.clear();
+        moved.trim_capacity();
+        const size_t allocations{ resource.allocations };
+        for (int i{}; i<8; ++i)
+            moved.emplace(i);
+        EXPECT_EQ(resource.allocations, allocations);
+    }
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
+TEST_F(HiveTest, SortAndUnique)
+{
+    std::mt19937 rng{ 7 };
+    for (int i{}; i<500; ++i)
+        h.emplace(static_cast<int>(rng() % 50));
+    erase_if(h, [](int val) { return val % 7 == 0; });
+
+    // sorting only moves values between the existing slots
+    std::vector<const int*> addresses;
+    for (const int& val : h)
+        addresses.push_back(&val);
+    std::multiset<int> values(h.begin(), h.end());
+
+    h.sort();
+    EXPECT_TRUE(std::ranges::is_sorted(h));
+    EXPECT_TRUE(std::ranges::equal(h, values));
+    std::vector<const int*> sorted_addresses;
+    for (const int& val : h)
+        sorted_addresses.push_back(&val);
+    EXPECT_EQ(sorted_addresses, addresses);
+
+    h.sort(std::greater<>{ });
+    EXPECT_TRUE(std::ranges::is_sorted(h, std::greater<>{ }));
+
+    const size_t erased{ h.unique() };
+    std::set<int> distinct(values.begin(), values.end());
+    EXPECT_EQ(erased, values.size() - distinct.size());
+    EXPECT_TRUE(std::ranges::equal(h, std::views::reverse(distinct)));
+
+    // non trivial elements move through assignment, unique takes a predicate
+    hive<std::string> words;
+    for (const char* word : { "pear", "fig", "apple", "kiwi", "plum", "date", "fig" })
+        words.emplace(word);
+    words.sort();
+    EXPECT_TRUE(std::ranges::equal(words, std::vector<std::string>{ "apple", "date", "fig", "fig", "kiwi", "pear", "plum" }));
+    const auto same_length = [](const std::string& a, const std::string& b) { return a.size() == b.size(); };
+    EXPECT_EQ(words.unique(same_length), 3);
+    EXPECT_TRUE(std::ranges::equal(words, std::vector<std::string>{ "apple", "date", "fig", "kiwi" }));
+
+    // narrower than the free list links, slots are strided
+    hive<char> letters;
+    for (char c : std::string("hivesort"))
+        letters.emplace(c);
+    letters.erase(letters.begin());
+    letters.sort();
+    EXPECT_TRUE(std::ranges::equal(letters, std::string("eiorstv")));
+    EXPECT_EQ(letters.unique(), 0);
+
+    // values too large to move around are permuted through their slots
+    struct Large
+    {
+        std::array<std::uint64_t, 40> pad;
+        std::string key;
+        bool operator<(const Large& other) const { return key < other.key; }
+    };
+    hive<Large> large;
+    for (const char* key : { "c", "a", "d", "b" })
+        large.emplace(Large{ { }, key });
+    large.sort();
+    EXPECT_TRUE(std::ranges::equal(large, std::vector<std::string>{ "a", "b", "c", "d" }, { }, &Large::key));
+}
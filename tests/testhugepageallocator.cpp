@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "huge_page_allocator.hpp"
+#include "hive.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+TEST(HugePageAllocatorTest, LargeAllocationsAreMapped)
+{
+    huge_page_allocator<int> alloc;
+    const size_t large{ huge_page_bytes / sizeof(int) + 1 };
+
+    int* mapped{ alloc.allocate(large) };
+    if (huge_page_allocator<int>::is_mapped(large))
+    {
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mapped) % huge_page_bytes, 0);
+    }
+    mapped[0] = 1;
+    mapped[large - 1] = 2;
+    alloc.deallocate(mapped, large);
+
+    int* small{ alloc.allocate(16) };
+    EXPECT_FALSE(huge_page_allocator<int>::is_mapped(16));
+    small[15] = 3;
+    alloc.deallocate(small, 16);
+}
+
+// Records the allocations that huge_page_allocator maps, hive rebinds it to its blocks
+template<typename T>
+struct recording_huge_page_allocator : huge_page_allocator<T>
+{
+    struct Mapping
+    {
+        std::uintptr_t address;
+        size_t bytes;
+    };
+    static inline std::vector<Mapping> mappings;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = recording_huge_page_allocator<U>;
+    };
+
+    recording_huge_page_allocator() = default;
+    template<typename U>
+    recording_huge_page_allocator(const recording_huge_page_allocator<U>&) noexcept { }
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+        T* p{ huge_page_allocator<T>::allocate(n) };
+        if (huge_page_allocator<T>::is_mapped(n))
+            recording_huge_page_allocator<std::byte>::mappings.push_back({ reinterpret_cast<std::uintptr_t>(p), n * sizeof(T) });
+        return p;
+    }
+};
+
+TEST(HugePageAllocatorTest, BacksHiveBlocks)
+{
+    if (!huge_page_allocator<int>::is_mapped(huge_page_bytes))
+        GTEST_SKIP() << "huge page mappings are Linux only";
+
+    auto& mappings = recording_huge_page_allocator<std::byte>::mappings;
+    mappings.clear();
+
+    // enough elements that the last blocks grow past a huge page and are mapped
+    hive<int, recording_huge_page_allocator<int>, std::uint32_t> h;
+    h.insert(1'000'000, 1);
+
+    // the blocks past a huge page were mapped on huge page boundaries
+    ASSERT_FALSE(mappings.empty());
+    for (const auto& mapping : mappings)
+    {
+        EXPECT_GE(mapping.bytes, huge_page_bytes);
+        EXPECT_EQ(mapping.address % huge_page_bytes, 0);
+    }
+
+    // and the last element lives in one of them
+    const auto last = reinterpret_cast<std::uintptr_t>(&*std::prev(h.end()));
+    EXPECT_TRUE(std::ranges::any_of(mappings, [last](const auto& mapping)
+    {
+        return last >= mapping.address && last < mapping.address + mapping.bytes;
+    }));
+
+    h.erase(h.begin(), std::next(h.begin(), 500'000));
+    EXPECT_EQ(std::accumulate(h.begin(), h.end(), 0), 500'000);
+    h.clear();
+    EXPECT_EQ(h.capacity(), 0);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "skipfield_scan.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace hive_detail;
+
+template<typename S>
+void check_against_scalar()
+{
+    std::mt19937 rng{ 42 };
+    for (int density : { 1, 8, 64, 1000 })
+    {
+        std::vector<S> skip(300);
+        for (auto& slot : skip)
+            slot = rng() % static_cast<unsigned>(density) == 0 ? S{ 1 } : S{ 0 };
+
+        for (size_t first{}; first<skip.size(); first += 7)
+            for (size_t last{ first }; last<=skip.size(); last += 13)
+                ASSERT_EQ(find_nonzero(skip.data(), first, last), find_nonzero_scalar(skip.data(), first, last));
+    }
+}
+
+TEST(SkipfieldScanTest, FindNonzeroMatchesScalar)
+{
+    check_against_scalar<std::uint8_t>();
+    check_against_scalar<std::uint16_t>();
+    check_against_scalar<std::uint32_t>();
+}
+
+TEST(SkipfieldScanTest, ActiveRuns)
+{
+    // active [0,2), erased [2,5), active [5,40), erased [40,42), active [42,50)
+    std::vector<std::uint16_t> skip(50, 0);
+    skip[2] = skip[4] = 3;
+    skip[40] = skip[41] = 2;
+
+    std::vector<std::pair<size_t, size_t>> runs;
+    for_each_active_run(skip.data(), 0, skip.size(), [&runs](size_t first, size_t last)
+    {
+        runs.emplace_back(first, last);
+    });
+    std::vector<std::pair<size_t, size_t>> expected{ { 0, 2 }, { 5, 40 }, { 42, 50 } };
+    EXPECT_EQ(runs, expected);
+
+    EXPECT_EQ(count_active(skip.data(), 0, skip.size()), 2+35+8);
+    EXPECT_EQ(count_active(skip.data(), 5, 41), 35);
+    EXPECT_EQ(count_active(skip.data(), 2, 2), 0);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "snapshot_hive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(SnapshotHiveTest, PinnedSnapshotOutlivesErase)
+{
+    snapshot_hive<std::string> h;
+    std::vector<snapshot_hive<std::string>::iterator> its;
+    for (int i{}; i<10; ++i)
+        its.push_back(h.emplace(std::to_string(i)));
+    EXPECT_TRUE(h.read().is_empty());
+    h.publish();
+
+    auto before = h.read();
+    EXPECT_EQ(before.size(), 10);
+
+    h.erase(its[3]);
+    h.erase(its[4]);
+    h.erase(its[9]);
+    h.publish();
+    EXPECT_EQ(h.size(), 7);
+
+    // the pinned reader still sees the erased elements, in place
+    EXPECT_EQ(h.retired_count(), 3);
+    std::vector<std::string> seen(before.begin(), before.end());
+    EXPECT_EQ(seen.size(), 10);
+    EXPECT_EQ(seen[3], "3");
+
+    {
+        auto after = h.read();
+        EXPECT_GT(after.epoch(), before.epoch());
+        std::vector<std::string> visible(after.begin(), after.end());
+        EXPECT_EQ(visible, (std::vector<std::string>{ "0", "1", "2", "5", "6", "7", "8" }));
+    }
+
+    // erasures complete once the old snapshot is released
+    { auto released = std::move(before); }
+    h.collect();
+    EXPECT_EQ(h.retired_count(), 0);
+
+    // an erase is never reclaimed before a snapshot without it is published
+    h.erase(its[0]);
+    h.collect();
+    EXPECT_EQ(h.retired_count(), 1);
+    EXPECT_EQ(h.read().size(), 7);
+    h.publish();
+    EXPECT_EQ(h.read().size(), 6);
+    EXPECT_EQ(h.retired_count(), 0);
+}
+
+TEST(SnapshotHiveTest, NarrowElements)
+{
+    // chars are stored in slots wider than themselves, runs are strided
+    snapshot_hive<char> h;
+    std::vector<snapshot_hive<char>::iterator> its;
+    for (char c : std::string("abcdef"))
+        its.push_back(h.emplace(c));
+    h.erase(its[1]);
+    h.publish();
+
+    auto s = h.read();
+    EXPECT_EQ(std::string(s.begin(), s.end()), "acdef");
+}
+
+TEST(SnapshotHiveTest, ReadersDuringWrites)
+{
+    // each published snapshot holds whole pairs, so a consistent reader always sees an even sum
+    snapshot_hive<std::uint64_t> h{ 4 };
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> scans{ };
+    std::atomic<int> readers_scanned{ };
+
+    std::vector<std::thread> readers;
+    for (int r{}; r<3; ++r)
+    {
+        readers.emplace_back([&]
+        {
+            bool scanned{ false };
+            while (!done.load())
+            {
+                auto s = h.read();
+                const std::uint64_t sum{ std::accumulate(s.begin(), s.end(), std::uint64_t{ 0 }) };
+                EXPECT_EQ(sum % 2, 0);
+                EXPECT_EQ(static_cast<size_t>(std::distance(s.begin(), s.end())), s.size());
+                scans.fetch_add(1);
+                if (!std::exchange(scanned, true))
+                    readers_scanned.fetch_add(1);
+            }
+        });
+    }
+
+    std::vector<snapshot_hive<std::uint64_t>::iterator> live;
+    for (int round{}; round<2000; ++round)
+    {
+        live.push_back(h.emplace(std::uint64_t{ 1 }));
+        live.push_back(h.emplace(std::uint64_t{ 1 }));
+        if (live.size() > 64)
+        {
+            h.erase(live[0]);
+            h.erase(live[1]);
+            live.erase(live.begin(), live.begin() + 2);
+        }
+        h.publish();
+    }
+
+    // the writer keeps going until every reader has finished a scan
+    while (readers_scanned.load() < 3)
+    {
+        h.publish();
+        std::this_thread::yield();
+    }
+    done.store(true);
+    for (auto& reader : readers)
+        reader.join();
+
+    h.collect();
+    EXPECT_EQ(h.retired_count(), 0);
+    EXPECT_EQ(h.read().size(), live.size());
+    EXPECT_GE(scans.load(), 3);
+}
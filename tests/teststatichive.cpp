@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "static_hive.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <string>
+#include <vector>
+
+// the allocator throws, so any of these reaching the heap fails the test
+TEST(StaticHiveTest, FillsWithoutAllocating)
+{
+    static_assert(std::same_as<static_hive<int, 200>::skipfield_type, std::uint8_t>);
+    static_assert(std::same_as<static_hive<int, 1000>::skipfield_type, std::uint16_t>);
+    static_assert(std::same_as<static_hive<int, 70000>::skipfield_type, std::uint32_t>);
+
+    static_hive<int, 8> h;
+    EXPECT_EQ(h.capacity(), 8);
+    std::vector<static_hive<int, 8>::iterator> its;
+    for (int i{}; i<8; ++i)
+        its.push_back(h.emplace(i));
+    EXPECT_TRUE(h.is_full());
+
+    // full, nothing is constructed
+    EXPECT_EQ(h.emplace(99), h.end());
+    EXPECT_FALSE(h.insert(1, 5));
+    EXPECT_EQ(h.size(), 8);
+
+    // erased slots are reused through the free list as in hive
+    h.erase(its[2]);
+    h.erase(its[3]);
+    EXPECT_TRUE(std::ranges::equal(h, std::vector<int>{ 0, 1, 4, 5, 6, 7 }));
+    auto it = h.emplace(42);
+    EXPECT_NE(it, h.end());
+    EXPECT_EQ(&*it, &*its[2]);
+    EXPECT_TRUE(h.insert(1, 43));
+    EXPECT_TRUE(h.is_full());
+
+    // emptying and refilling reuses the inline block
+    h.clear();
+    EXPECT_TRUE(h.is_empty());
+    const std::vector<int> values{ 1, 2, 2, 3, 3, 3 };
+    EXPECT_TRUE(h.insert(values.begin(), values.end()));
+    EXPECT_FALSE(h.insert(values.begin(), values.end()));
+    EXPECT_EQ(h.unique(), 3);
+    EXPECT_EQ(erase_if(h, [](int val) { return val == 2; }), 1);
+    EXPECT_TRUE(std::ranges::equal(h, std::vector<int>{ 1, 3 }));
+}
+
+TEST(StaticHiveTest, CopyMoveSwap)
+{
+    static_hive<std::string, 4> a{ "w", "x", "y" };
+    EXPECT_THROW((static_hive<std::string, 2>{ "a", "b", "c" }), std::length_error);
+
+    static_hive<std::string, 4> copy{ a };
+    EXPECT_TRUE(std::ranges::equal(copy, a));
+
+    static_hive<std::string, 4> moved{ std::move(copy) };
+    EXPECT_TRUE(copy.is_empty());
+    EXPECT_EQ(moved.size(), 3);
+
+    static_hive<std::string, 4> b{ "z" };
+    swap(a, b);
+    EXPECT_TRUE(std::ranges::equal(a, std::vector<std::string>{ "z" }));
+    EXPECT_EQ(b.size(), 3);
+
+    size_t total{ };
+    b.for_each_segment([&total](std::span<std::string> seg) { total += seg.size(); });
+    EXPECT_EQ(total, 3);
+}